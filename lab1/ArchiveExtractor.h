@@ -0,0 +1,111 @@
+#pragma once
+#include "ArchiveIndex.h"
+#include "Codec.h"
+#include "FileContent.h"
+#include "TarReader.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Члены больше порога распаковываются рабочим потоком прямо из архива через pread, не занимая память
+constexpr uint64_t STREAMED_MEMBER_SIZE = 16 << 20;
+
+inline std::filesystem::path GetOutputPath(std::string const& outputFolder, std::string memberName, Codec const& codec)
+{
+	if (const auto extension = codec.GetExtension(); !extension.empty() && memberName.ends_with(extension))
+	{
+		memberName.resize(memberName.size() - extension.size());
+	}
+	const std::filesystem::path name(memberName);
+	if (name.is_absolute() || std::ranges::any_of(name, [](auto const& part) { return part == ".."; }))
+	{
+		throw std::runtime_error("Unsafe path in archive: " + memberName);
+	}
+	return std::filesystem::path(outputFolder) / name;
+}
+
+inline Codec const& GetMemberCodec(TarMember const& member)
+{
+	return member.codec ? GetCodec(*member.codec) : GetCodecByMemberName(member.name);
+}
+
+// Возвращает время занятости каждого рабочего потока
+inline std::vector<std::chrono::milliseconds> ExtractArchive(std::string const& archivePath, std::string const& outputFolder, const unsigned threadsNum)
+{
+	// задания, читающие большие члены через pread, владеют дескриптором наравне с читателем
+	const auto input = std::make_shared<FileDesc>(OpenFile(archivePath, O_RDONLY));
+	TarReader reader(*input);
+	WorkerPool pool(threadsNum);
+	std::deque<std::future<void>> inFlight;
+	const auto maxInFlight = pool.GetThreadsNum() * 2;
+	// future снимается с очереди до get(): если задание бросило, в catch ждём только оставшиеся
+	auto waitFront = [&] {
+		auto future = std::move(inFlight.front());
+		inFlight.pop_front();
+		future.get();
+	};
+	auto dispatch = [&](auto&& task) {
+		while (inFlight.size() >= maxInFlight)
+		{
+			waitFront();
+		}
+		inFlight.emplace_back(pool.Submit(std::forward<decltype(task)>(task)));
+	};
+
+	try
+	{
+		while (const auto member = reader.Next())
+		{
+			if (member->name == ARCHIVE_INDEX_NAME)
+			{
+				continue;
+			}
+			if (member->type == '5')
+			{
+				std::filesystem::create_directories(GetOutputPath(outputFolder, member->name, GetCodec(CodecId::Store)));
+				continue;
+			}
+			if (member->type != '0')
+			{
+				continue;
+			}
+
+			auto const& codec = GetMemberCodec(*member);
+			auto path = GetOutputPath(outputFolder, member->name, codec);
+			std::filesystem::create_directories(path.parent_path());
+			if (reader.IsSeekable() && member->size > STREAMED_MEMBER_SIZE)
+			{
+				dispatch([input, &codec, offset = member->dataOffset, size = member->size, path = std::move(path)] {
+					codec.DecompressRangeToFile(*input, offset, size, path);
+				});
+				continue;
+			}
+
+			dispatch([&codec, data = reader.ReadData(*member), path = std::move(path)] {
+				WriteFileContent(path, codec.Decompress(data, 0));
+			});
+		}
+
+		while (!inFlight.empty())
+		{
+			waitFront();
+		}
+	}
+	catch (...)
+	{
+		// выходим только после уже запущенных заданий, чтобы вызывающий мог безопасно убрать выходную папку
+		for (auto& future : inFlight)
+		{
+			future.wait();
+		}
+		throw;
+	}
+
+	return pool.GetBusyTimes();
+}
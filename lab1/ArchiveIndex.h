@@ -0,0 +1,142 @@
+#pragma once
+#include "ByteOrder.h"
+#include "FileContent.h"
+#include "TarWriter.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+// Индекс пишется последним членом архива. Его данные выровнены на блок tar и заканчиваются футером
+// [смещение данных индекса, магия], поэтому футер всегда лежит сразу перед двумя завершающими нулевыми блоками
+inline const std::string ARCHIVE_INDEX_NAME = ".archive-index";
+constexpr char ARCHIVE_INDEX_MAGIC[8] = { 'A', 'R', 'C', 'I', 'D', 'X', '0', '3' };
+// версия без хеша содержимого, читается для совместимости
+constexpr char ARCHIVE_INDEX_MAGIC_V2[8] = { 'A', 'R', 'C', 'I', 'D', 'X', '0', '2' };
+constexpr char ARCHIVE_INDEX_FOOTER_MAGIC[8] = { 'A', 'R', 'C', 'I', 'D', 'X', 'F', 'T' };
+constexpr size_t ARCHIVE_INDEX_FOOTER_SIZE = 16;
+
+struct IndexEntry
+{
+	std::string name;
+	uint64_t offset = 0;
+	uint64_t compressedSize = 0;
+	uint64_t rawSize = 0;
+	uint32_t crc = 0;
+	uint8_t codec = 0;
+	// хеш несжатого содержимого (HashFileContent), 0 - неизвестен (индекс ARCIDX02)
+	uint64_t contentHash = 0;
+};
+
+// dataOffset - смещение, по которому данные индекса окажутся в архиве (TarWriter::BeginFile)
+inline std::vector<char> SerializeIndex(std::vector<IndexEntry> const& entries, const uint64_t dataOffset)
+{
+	std::vector<char> result(std::begin(ARCHIVE_INDEX_MAGIC), std::end(ARCHIVE_INDEX_MAGIC));
+	AppendLittleEndian<uint64_t>(result, entries.size());
+	for (const auto& entry : entries)
+	{
+		AppendLittleEndian<uint32_t>(result, static_cast<uint32_t>(entry.name.size()));
+		result.insert(result.end(), entry.name.begin(), entry.name.end());
+		AppendLittleEndian<uint64_t>(result, entry.offset);
+		AppendLittleEndian<uint64_t>(result, entry.compressedSize);
+		AppendLittleEndian<uint64_t>(result, entry.rawSize);
+		AppendLittleEndian<uint32_t>(result, entry.crc);
+		AppendLittleEndian<uint8_t>(result, entry.codec);
+		AppendLittleEndian<uint64_t>(result, entry.contentHash);
+	}
+
+	const auto paddedSize = (result.size() + ARCHIVE_INDEX_FOOTER_SIZE + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+	result.resize(paddedSize - ARCHIVE_INDEX_FOOTER_SIZE);
+	AppendLittleEndian<uint64_t>(result, dataOffset);
+	result.insert(result.end(), std::begin(ARCHIVE_INDEX_FOOTER_MAGIC), std::end(ARCHIVE_INDEX_FOOTER_MAGIC));
+
+	return result;
+}
+
+inline std::vector<IndexEntry> ParseIndex(std::span<const char> data)
+{
+	if (data.size() < sizeof(ARCHIVE_INDEX_MAGIC))
+	{
+		throw std::runtime_error("Invalid archive index");
+	}
+	const bool hasContentHash = std::memcmp(data.data(), ARCHIVE_INDEX_MAGIC, sizeof(ARCHIVE_INDEX_MAGIC)) == 0;
+	if (!hasContentHash && std::memcmp(data.data(), ARCHIVE_INDEX_MAGIC_V2, sizeof(ARCHIVE_INDEX_MAGIC_V2)) != 0)
+	{
+		throw std::runtime_error("Invalid archive index");
+	}
+
+	size_t pos = sizeof(ARCHIVE_INDEX_MAGIC);
+	const auto count = ReadLittleEndian<uint64_t>(data, pos);
+	std::vector<IndexEntry> entries;
+	entries.reserve(std::min<uint64_t>(count, data.size()));
+	for (uint64_t i = 0; i < count; ++i)
+	{
+		const auto nameSize = ReadLittleEndian<uint32_t>(data, pos);
+		if (pos + nameSize > data.size())
+		{
+			throw std::runtime_error("Archive index is truncated");
+		}
+		IndexEntry entry{ .name = std::string(data.data() + pos, nameSize) };
+		pos += nameSize;
+		entry.offset = ReadLittleEndian<uint64_t>(data, pos);
+		entry.compressedSize = ReadLittleEndian<uint64_t>(data, pos);
+		entry.rawSize = ReadLittleEndian<uint64_t>(data, pos);
+		entry.crc = ReadLittleEndian<uint32_t>(data, pos);
+		entry.codec = ReadLittleEndian<uint8_t>(data, pos);
+		if (hasContentHash)
+		{
+			entry.contentHash = ReadLittleEndian<uint64_t>(data, pos);
+		}
+		entries.push_back(std::move(entry));
+	}
+
+	return entries;
+}
+
+// Читает индекс с конца архива, не просматривая члены. nullopt - архив записан без индекса
+inline std::optional<std::vector<IndexEntry>> ReadIndex(FileDesc const& archive)
+{
+	struct stat st{};
+	if (fstat(archive.Get(), &st) != 0)
+	{
+		throw std::system_error(errno, std::generic_category(), "Error reading archive");
+	}
+	const auto archiveSize = static_cast<uint64_t>(st.st_size);
+	constexpr auto tailSize = 2 * TAR_BLOCK_SIZE + ARCHIVE_INDEX_FOOTER_SIZE;
+	if (archiveSize < tailSize + TAR_BLOCK_SIZE)
+	{
+		return std::nullopt;
+	}
+
+	const auto footerOffset = archiveSize - tailSize;
+	const auto footer = ReadFileRange(archive, footerOffset, ARCHIVE_INDEX_FOOTER_SIZE);
+	if (footer.size() != ARCHIVE_INDEX_FOOTER_SIZE
+		|| std::memcmp(footer.data() + 8, ARCHIVE_INDEX_FOOTER_MAGIC, sizeof(ARCHIVE_INDEX_FOOTER_MAGIC)) != 0)
+	{
+		return std::nullopt;
+	}
+	size_t pos = 0;
+	const auto indexOffset = ReadLittleEndian<uint64_t>(footer, pos);
+	if (indexOffset >= footerOffset)
+	{
+		throw std::runtime_error("Invalid archive index offset");
+	}
+
+	return ParseIndex(ReadFileRange(archive, indexOffset, footerOffset - indexOffset));
+}
+
+inline std::optional<IndexEntry> FindIndexEntry(std::vector<IndexEntry> const& entries, std::string name)
+{
+	name.erase(0, name.find_first_not_of('/'));
+	const auto it = std::ranges::find(entries, name, &IndexEntry::name);
+	if (it == entries.end())
+	{
+		return std::nullopt;
+	}
+	return *it;
+}
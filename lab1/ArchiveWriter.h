@@ -0,0 +1,149 @@
+#pragma once
+#include "ArchiveIndex.h"
+#include "Codec.h"
+#include "CodecSelector.h"
+#include "FileContent.h"
+#include "ParallelCompression.h"
+#include "TarWriter.h"
+#include "WorkerPool.h"
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Пишет сжатые файлы членами tar и собирает для них индекс
+class ArchiveSink
+{
+public:
+	explicit ArchiveSink(TarWriter& writer)
+		: m_writer(writer)
+	{
+	}
+
+	void AddFile(FileInfo const& info, CompressedBlock const& block)
+	{
+		const auto offset = m_writer.AddFile(GetMemberInfo(info, *block.codec), block.data);
+		AddIndexEntry(info, *block.codec, offset, block.data.size(), block.rawSize, block.crc, block.contentHash);
+	}
+
+	void BeginFile(FileInfo const& info, Codec const& codec)
+	{
+		m_pendingOffset = m_writer.BeginFile(GetMemberInfo(info, codec));
+		m_pendingSize = 0;
+		m_pendingCodec = &codec;
+	}
+
+	void AppendData(std::span<const char> data)
+	{
+		m_writer.AppendData(data);
+		m_pendingSize += data.size();
+	}
+
+	void EndFile(FileInfo const& info, const uLong crc, const uint64_t rawSize, const uint64_t contentHash)
+	{
+		m_writer.EndFile();
+		AddIndexEntry(info, *m_pendingCodec, m_pendingOffset, m_pendingSize, rawSize, crc, contentHash);
+	}
+
+	// Файлы, чьи члены переносятся из другого архива как есть, без повторного сжатия
+	void SetReusedMembers(FileDesc const& archive, std::unordered_map<std::string, IndexEntry const*> members)
+	{
+		m_reuseArchive = &archive;
+		m_reusedMembers = std::move(members);
+	}
+
+	[[nodiscard]] bool IsReused(FileInfo const& info) const
+	{
+		return m_reusedMembers.contains(info.name);
+	}
+
+	void CopyReusedFile(FileInfo const& info)
+	{
+		auto const& entry = *m_reusedMembers.at(info.name);
+		BeginFile(info, GetCodec(static_cast<CodecId>(entry.codec)));
+		for (uint64_t offset = 0; offset < entry.compressedSize; offset += COPY_CHUNK_SIZE)
+		{
+			const auto size = std::min<uint64_t>(COPY_CHUNK_SIZE, entry.compressedSize - offset);
+			const auto data = ReadFileRange(*m_reuseArchive, entry.offset + offset, size);
+			if (data.size() != size)
+			{
+				throw std::runtime_error("Unexpected end of archive while copying " + entry.name);
+			}
+			AppendData(data);
+		}
+		EndFile(info, entry.crc, entry.rawSize, entry.contentHash);
+	}
+
+	void WriteIndex()
+	{
+		const auto offset = m_writer.BeginFile({ .name = ARCHIVE_INDEX_NAME, .mtime = std::time(nullptr) });
+		m_writer.AppendData(SerializeIndex(m_index, offset));
+		m_writer.EndFile();
+	}
+
+private:
+	static TarMemberInfo GetMemberInfo(FileInfo const& info, Codec const& codec)
+	{
+		TarMemberInfo member{
+			.name = info.name + std::string(codec.GetExtension()),
+			.mode = info.mode,
+			.mtime = info.mtime,
+		};
+		// иначе распаковщик примет сохранённый как есть file.gz за сжатый
+		if (&GetCodecByMemberName(member.name) != &codec)
+		{
+			member.paxRecords.emplace_back(CODEC_PAX_KEY, std::string(codec.GetName()));
+		}
+		return member;
+	}
+
+	void AddIndexEntry(FileInfo const& info, Codec const& codec, const uint64_t offset, const uint64_t compressedSize, const uint64_t rawSize,
+		const uLong crc, const uint64_t contentHash)
+	{
+		auto name = info.name;
+		name.erase(0, name.find_first_not_of('/'));
+		m_index.push_back({
+			.name = std::move(name),
+			.offset = offset,
+			.compressedSize = compressedSize,
+			.rawSize = rawSize,
+			.crc = static_cast<uint32_t>(crc),
+			.codec = static_cast<uint8_t>(codec.GetId()),
+			.contentHash = contentHash,
+		});
+	}
+
+	static constexpr uint64_t COPY_CHUNK_SIZE = 1 << 20;
+
+	TarWriter& m_writer;
+	FileDesc const* m_reuseArchive = nullptr;
+	std::unordered_map<std::string, IndexEntry const*> m_reusedMembers;
+	std::vector<IndexEntry> m_index;
+	uint64_t m_pendingOffset = 0;
+	uint64_t m_pendingSize = 0;
+	Codec const* m_pendingCodec = nullptr;
+};
+
+// Pool - WorkerPool или ProcessPool (ProcessCompression.h)
+template <typename Pool>
+void WriteArchive(std::string const& archivePath, std::vector<std::string> const& files, Pool& pool, const size_t maxInFlight,
+	CodecSelector const& selector)
+{
+	auto output = OpenFile(archivePath, O_WRONLY | O_CREAT | O_TRUNC);
+	TarWriter writer(output);
+	ArchiveSink sink(writer);
+	CompressFilesOrdered(files, selector, pool, maxInFlight, sink);
+	sink.WriteIndex();
+	writer.Finish();
+	output.Close();
+}
+
+// Возвращает время занятости каждого рабочего потока
+inline std::vector<std::chrono::milliseconds> WriteArchive(std::string const& archivePath, std::vector<std::string> const& files,
+	const unsigned threadsNum, CodecSelector const& selector)
+{
+	WorkerPool pool(threadsNum);
+	WriteArchive(archivePath, files, pool, pool.GetThreadsNum() * 2, selector);
+	return pool.GetBusyTimes();
+}
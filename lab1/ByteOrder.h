@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+template <typename T>
+void AppendLittleEndian(std::vector<char>& output, T value)
+{
+	for (size_t i = 0; i < sizeof(T); ++i)
+	{
+		output.push_back(static_cast<char>((static_cast<uint64_t>(value) >> (8 * i)) & 0xff));
+	}
+}
+
+template <typename T>
+T ReadLittleEndian(std::span<const char> input, size_t& pos)
+{
+	if (pos + sizeof(T) > input.size())
+	{
+		throw std::runtime_error("Unexpected end of binary data");
+	}
+	uint64_t value = 0;
+	for (size_t i = 0; i < sizeof(T); ++i)
+	{
+		value |= static_cast<uint64_t>(static_cast<unsigned char>(input[pos + i])) << (8 * i);
+	}
+	pos += sizeof(T);
+	return static_cast<T>(value);
+}
@@ -0,0 +1,404 @@
+#pragma once
+#include "FileContent.h"
+#include "Gzip.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <zlib.h>
+
+#ifdef ARCHIVE_WITH_ZSTD
+#include <zstd.h>
+#endif
+#ifdef ARCHIVE_WITH_LZ4
+#include <lz4frame.h>
+#endif
+
+enum class CodecId : uint8_t
+{
+	Store = 0,
+	Deflate = 1,
+	Zstd = 2,
+	Lz4 = 3,
+};
+
+class Codec
+{
+public:
+	virtual ~Codec() = default;
+
+	[[nodiscard]] virtual CodecId GetId() const = 0;
+	[[nodiscard]] virtual std::string_view GetName() const = 0;
+	// Суффикс имени члена архива, по которому codec определяется при распаковке
+	[[nodiscard]] virtual std::string_view GetExtension() const = 0;
+
+	[[nodiscard]] virtual std::vector<char> Compress(std::span<const char> data) const = 0;
+	[[nodiscard]] virtual std::vector<char> Decompress(std::span<const char> data, uint64_t rawSizeHint) const = 0;
+
+	// Блоки большого файла сжимаются независимо и склеиваются между StreamHeader и StreamTrailer.
+	// По умолчанию каждый блок - отдельный кадр, а склеенные кадры codec читает как один поток
+	[[nodiscard]] virtual std::vector<char> CompressBlock(std::span<const char> data, std::span<const char> /*dictionary*/, bool /*last*/) const
+	{
+		return Compress(data);
+	}
+
+	[[nodiscard]] virtual std::vector<char> StreamHeader() const
+	{
+		return {};
+	}
+
+	[[nodiscard]] virtual std::vector<char> StreamTrailer(uLong /*crc*/, uint64_t /*rawSize*/) const
+	{
+		return {};
+	}
+
+	virtual void DecompressRangeToFile(FileDesc const& input, const uint64_t offset, const uint64_t size, std::string const& outputPath) const
+	{
+		WriteFileContent(outputPath, Decompress(ReadFileRange(input, offset, size), 0));
+	}
+};
+
+class StoreCodec final : public Codec
+{
+public:
+	[[nodiscard]] CodecId GetId() const override { return CodecId::Store; }
+	[[nodiscard]] std::string_view GetName() const override { return "store"; }
+	[[nodiscard]] std::string_view GetExtension() const override { return ""; }
+
+	[[nodiscard]] std::vector<char> Compress(std::span<const char> data) const override
+	{
+		return { data.begin(), data.end() };
+	}
+
+	[[nodiscard]] std::vector<char> Decompress(std::span<const char> data, uint64_t) const override
+	{
+		return { data.begin(), data.end() };
+	}
+
+	void DecompressRangeToFile(FileDesc const& input, const uint64_t offset, const uint64_t size, std::string const& outputPath) const override
+	{
+		constexpr uint64_t chunkSize = 1 << 20;
+		auto output = OpenFile(outputPath, O_WRONLY | O_CREAT | O_TRUNC);
+		for (uint64_t done = 0; done < size; done += chunkSize)
+		{
+			const auto chunk = ReadFileRange(input, offset + done, std::min(chunkSize, size - done));
+			output.Write(chunk.data(), chunk.size());
+		}
+		output.Close();
+	}
+};
+
+class DeflateCodec final : public Codec
+{
+public:
+	explicit DeflateCodec(const int level = Z_DEFAULT_COMPRESSION)
+		: m_level(level)
+	{
+	}
+
+	[[nodiscard]] CodecId GetId() const override { return CodecId::Deflate; }
+	[[nodiscard]] std::string_view GetName() const override { return "gzip"; }
+	[[nodiscard]] std::string_view GetExtension() const override { return ".gz"; }
+
+	[[nodiscard]] std::vector<char> Compress(std::span<const char> data) const override
+	{
+		return GzipCompress(data, m_level);
+	}
+
+	[[nodiscard]] std::vector<char> Decompress(std::span<const char> data, uint64_t) const override
+	{
+		return GzipDecompress(data);
+	}
+
+	[[nodiscard]] std::vector<char> CompressBlock(std::span<const char> data, std::span<const char> dictionary, const bool last) const override
+	{
+		return DeflateBlock(data, dictionary, last, m_level);
+	}
+
+	[[nodiscard]] std::vector<char> StreamHeader() const override
+	{
+		const auto header = GzipHeader();
+		return { header.begin(), header.end() };
+	}
+
+	[[nodiscard]] std::vector<char> StreamTrailer(const uLong crc, const uint64_t rawSize) const override
+	{
+		const auto trailer = GzipTrailer(crc, rawSize);
+		return { trailer.begin(), trailer.end() };
+	}
+
+	void DecompressRangeToFile(FileDesc const& input, const uint64_t offset, const uint64_t size, std::string const& outputPath) const override
+	{
+		GunzipRangeToFile(input, offset, size, outputPath);
+	}
+
+private:
+	int m_level;
+};
+
+#ifdef ARCHIVE_WITH_ZSTD
+class ZstdCodec final : public Codec
+{
+public:
+	explicit ZstdCodec(const int level = 3)
+		: m_level(level)
+	{
+	}
+
+	[[nodiscard]] CodecId GetId() const override { return CodecId::Zstd; }
+	[[nodiscard]] std::string_view GetName() const override { return "zstd"; }
+	[[nodiscard]] std::string_view GetExtension() const override { return ".zst"; }
+
+	[[nodiscard]] std::vector<char> Compress(std::span<const char> data) const override
+	{
+		std::vector<char> result(ZSTD_compressBound(data.size()));
+		const auto size = ZSTD_compress(result.data(), result.size(), data.data(), data.size(), m_level);
+		if (ZSTD_isError(size))
+		{
+			throw std::runtime_error(std::string("Error compressing data: ") + ZSTD_getErrorName(size));
+		}
+		result.resize(size);
+		return result;
+	}
+
+	[[nodiscard]] std::vector<char> Decompress(std::span<const char> data, const uint64_t rawSizeHint) const override
+	{
+		std::vector<char> result;
+		result.reserve(rawSizeHint);
+		const auto status = DecompressStream(data, [&](std::span<const char> chunk) {
+			result.insert(result.end(), chunk.begin(), chunk.end());
+		});
+		CheckFrameComplete(status);
+		return result;
+	}
+
+	void DecompressRangeToFile(FileDesc const& input, const uint64_t offset, const uint64_t size, std::string const& outputPath) const override
+	{
+		auto output = OpenFile(outputPath, O_WRONLY | O_CREAT | O_TRUNC);
+		const auto chunkSize = ZSTD_DStreamInSize();
+		const std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+		size_t status = 0;
+		for (uint64_t done = 0; done < size; done += chunkSize)
+		{
+			const auto chunk = ReadFileRange(input, offset + done, std::min<uint64_t>(chunkSize, size - done));
+			status = DecompressStream(chunk, [&](std::span<const char> out) {
+				output.Write(out.data(), out.size());
+			}, context.get());
+		}
+		CheckFrameComplete(status);
+		output.Close();
+	}
+
+private:
+	// ZSTD_decompressStream возвращает 0 только на границе кадра, иначе данные обрезаны
+	static void CheckFrameComplete(const size_t status)
+	{
+		if (status != 0)
+		{
+			throw std::runtime_error("Unexpected end of zstd frame");
+		}
+	}
+
+	// Возвращает результат последнего ZSTD_decompressStream
+	template <typename Consumer>
+	static size_t DecompressStream(std::span<const char> data, Consumer&& consumer, ZSTD_DCtx* context = nullptr)
+	{
+		std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> ownContext(nullptr, &ZSTD_freeDCtx);
+		if (!context)
+		{
+			ownContext.reset(ZSTD_createDCtx());
+			context = ownContext.get();
+		}
+
+		std::vector<char> buffer(ZSTD_DStreamOutSize());
+		ZSTD_inBuffer in{ data.data(), data.size(), 0 };
+		ZSTD_outBuffer out{};
+		size_t status = 0;
+		do
+		{
+			out = { buffer.data(), buffer.size(), 0 };
+			status = ZSTD_decompressStream(context, &out, &in);
+			if (ZSTD_isError(status))
+			{
+				throw std::runtime_error(std::string("Error decompressing data: ") + ZSTD_getErrorName(status));
+			}
+			consumer(std::span<const char>(buffer.data(), out.pos));
+		} while (in.pos < in.size || out.pos == out.size);
+		return status;
+	}
+
+	int m_level;
+};
+#endif
+
+#ifdef ARCHIVE_WITH_LZ4
+class Lz4Codec final : public Codec
+{
+public:
+	[[nodiscard]] CodecId GetId() const override { return CodecId::Lz4; }
+	[[nodiscard]] std::string_view GetName() const override { return "lz4"; }
+	[[nodiscard]] std::string_view GetExtension() const override { return ".lz4"; }
+
+	[[nodiscard]] std::vector<char> Compress(std::span<const char> data) const override
+	{
+		LZ4F_preferences_t preferences{};
+		preferences.frameInfo.contentSize = data.size();
+		std::vector<char> result(LZ4F_compressFrameBound(data.size(), &preferences));
+		const auto size = LZ4F_compressFrame(result.data(), result.size(), data.data(), data.size(), &preferences);
+		if (LZ4F_isError(size))
+		{
+			throw std::runtime_error(std::string("Error compressing data: ") + LZ4F_getErrorName(size));
+		}
+		result.resize(size);
+		return result;
+	}
+
+	[[nodiscard]] std::vector<char> Decompress(std::span<const char> data, const uint64_t rawSizeHint) const override
+	{
+		std::vector<char> result;
+		result.reserve(rawSizeHint);
+		const auto context = CreateContext();
+		const auto status = DecompressStream(context.get(), data, [&](std::span<const char> chunk) {
+			result.insert(result.end(), chunk.begin(), chunk.end());
+		});
+		CheckFrameComplete(status);
+		return result;
+	}
+
+	void DecompressRangeToFile(FileDesc const& input, const uint64_t offset, const uint64_t size, std::string const& outputPath) const override
+	{
+		constexpr uint64_t chunkSize = 256 * 1024;
+		auto output = OpenFile(outputPath, O_WRONLY | O_CREAT | O_TRUNC);
+		const auto context = CreateContext();
+		size_t status = 0;
+		for (uint64_t done = 0; done < size; done += chunkSize)
+		{
+			const auto chunk = ReadFileRange(input, offset + done, std::min(chunkSize, size - done));
+			status = DecompressStream(context.get(), chunk, [&](std::span<const char> out) {
+				output.Write(out.data(), out.size());
+			});
+		}
+		CheckFrameComplete(status);
+		output.Close();
+	}
+
+private:
+	using ContextPtr = std::unique_ptr<LZ4F_dctx, decltype(&LZ4F_freeDecompressionContext)>;
+
+	static ContextPtr CreateContext()
+	{
+		LZ4F_dctx* context = nullptr;
+		if (LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION)))
+		{
+			throw std::runtime_error("Error initializing lz4 decompression");
+		}
+		return { context, &LZ4F_freeDecompressionContext };
+	}
+
+	// LZ4F_decompress возвращает 0, только когда прочитана концевая метка кадра
+	static void CheckFrameComplete(const size_t status)
+	{
+		if (status != 0)
+		{
+			throw std::runtime_error("Unexpected end of lz4 frame");
+		}
+	}
+
+	// Возвращает результат последнего LZ4F_decompress
+	template <typename Consumer>
+	static size_t DecompressStream(LZ4F_dctx* context, std::span<const char> data, Consumer&& consumer)
+	{
+		std::vector<char> buffer(256 * 1024);
+		size_t pos = 0;
+		size_t outSize = 0;
+		size_t status = 0;
+		do
+		{
+			outSize = buffer.size();
+			size_t inSize = data.size() - pos;
+			status = LZ4F_decompress(context, buffer.data(), &outSize, data.data() + pos, &inSize, nullptr);
+			if (LZ4F_isError(status))
+			{
+				throw std::runtime_error(std::string("Error decompressing data: ") + LZ4F_getErrorName(status));
+			}
+			pos += inSize;
+			consumer(std::span<const char>(buffer.data(), outSize));
+		} while (pos < data.size() || outSize == buffer.size());
+		return status;
+	}
+};
+#endif
+
+inline Codec const& GetCodec(const CodecId id)
+{
+	static const StoreCodec store;
+	static const DeflateCodec deflate;
+#ifdef ARCHIVE_WITH_ZSTD
+	static const ZstdCodec zstd;
+#endif
+#ifdef ARCHIVE_WITH_LZ4
+	static const Lz4Codec lz4;
+#endif
+
+	switch (id)
+	{
+	case CodecId::Store:
+		return store;
+	case CodecId::Deflate:
+		return deflate;
+#ifdef ARCHIVE_WITH_ZSTD
+	case CodecId::Zstd:
+		return zstd;
+#endif
+#ifdef ARCHIVE_WITH_LZ4
+	case CodecId::Lz4:
+		return lz4;
+#endif
+	default:
+		throw std::runtime_error("Codec is not available in this build: " + std::to_string(static_cast<int>(id)));
+	}
+}
+
+inline std::vector<CodecId> GetAvailableCodecs()
+{
+	return {
+		CodecId::Store,
+		CodecId::Deflate,
+#ifdef ARCHIVE_WITH_ZSTD
+		CodecId::Zstd,
+#endif
+#ifdef ARCHIVE_WITH_LZ4
+		CodecId::Lz4,
+#endif
+	};
+}
+
+inline Codec const& GetCodec(std::string_view name)
+{
+	for (const auto id : GetAvailableCodecs())
+	{
+		if (GetCodec(id).GetName() == name)
+		{
+			return GetCodec(id);
+		}
+	}
+	throw std::invalid_argument("Unknown or unavailable codec: " + std::string(name));
+}
+
+// Codec по суффиксу имени члена архива; члены без известного суффикса хранятся как есть
+inline Codec const& GetCodecByMemberName(std::string_view name)
+{
+	for (const auto id : GetAvailableCodecs())
+	{
+		const auto extension = GetCodec(id).GetExtension();
+		if (!extension.empty() && name.ends_with(extension))
+		{
+			return GetCodec(id);
+		}
+	}
+	return GetCodec(CodecId::Store);
+}
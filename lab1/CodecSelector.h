@@ -0,0 +1,112 @@
+#pragma once
+#include "Codec.h"
+#include "FileContent.h"
+#include <optional>
+#include <span>
+#include <vector>
+#include <zlib.h>
+
+// Выбирает codec для файла: либо заданный явно, либо по пробному сжатию нескольких фрагментов.
+// Несжимаемые данные (медиа, архивы) сохраняются как есть
+class CodecSelector
+{
+public:
+	static constexpr size_t SAMPLE_SIZE = 16 * 1024;
+	static constexpr size_t SAMPLES_NUM = 4;
+	static constexpr double STORE_RATIO = 0.9;
+
+	explicit CodecSelector(std::optional<CodecId> fixed)
+		: m_fixed(fixed)
+	{
+	}
+
+	[[nodiscard]] bool IsAuto() const
+	{
+		return !m_fixed.has_value();
+	}
+
+	[[nodiscard]] std::optional<CodecId> GetFixedCodec() const
+	{
+		return m_fixed;
+	}
+
+	[[nodiscard]] Codec const& Select(std::span<const char> content) const
+	{
+		if (m_fixed)
+		{
+			return GetCodec(*m_fixed);
+		}
+
+		std::vector<char> sample;
+		sample.reserve(SAMPLE_SIZE * SAMPLES_NUM);
+		for (const auto& [offset, size] : GetSampleRanges(content.size()))
+		{
+			sample.insert(sample.end(), content.begin() + static_cast<std::ptrdiff_t>(offset), content.begin() + static_cast<std::ptrdiff_t>(offset + size));
+		}
+		return SelectBySample(sample);
+	}
+
+	[[nodiscard]] Codec const& Select(FileDesc const& file, const uint64_t size) const
+	{
+		if (m_fixed)
+		{
+			return GetCodec(*m_fixed);
+		}
+
+		std::vector<char> sample;
+		sample.reserve(SAMPLE_SIZE * SAMPLES_NUM);
+		for (const auto& [offset, rangeSize] : GetSampleRanges(size))
+		{
+			const auto part = ReadFileRange(file, offset, rangeSize);
+			sample.insert(sample.end(), part.begin(), part.end());
+		}
+		return SelectBySample(sample);
+	}
+
+private:
+	static std::vector<std::pair<uint64_t, size_t>> GetSampleRanges(const uint64_t size)
+	{
+		if (size <= SAMPLE_SIZE * SAMPLES_NUM)
+		{
+			return { { 0, size } };
+		}
+
+		std::vector<std::pair<uint64_t, size_t>> ranges;
+		const auto step = (size - SAMPLE_SIZE) / (SAMPLES_NUM - 1);
+		for (size_t i = 0; i < SAMPLES_NUM; ++i)
+		{
+			ranges.emplace_back(i * step, SAMPLE_SIZE);
+		}
+		return ranges;
+	}
+
+	static Codec const& SelectBySample(std::span<const char> sample)
+	{
+		if (sample.empty())
+		{
+			return GetCodec(CodecId::Store);
+		}
+
+		// deflate с уровнем 1 дёшев и хорошо предсказывает сжимаемость для любого codec
+		auto bound = compressBound(static_cast<uLong>(sample.size()));
+		std::vector<Bytef> compressed(bound);
+		if (compress2(compressed.data(), &bound, reinterpret_cast<const Bytef*>(sample.data()), static_cast<uLong>(sample.size()), 1) != Z_OK)
+		{
+			return GetPreferredCodec();
+		}
+
+		const auto ratio = static_cast<double>(bound) / static_cast<double>(sample.size());
+		return ratio > STORE_RATIO ? GetCodec(CodecId::Store) : GetPreferredCodec();
+	}
+
+	static Codec const& GetPreferredCodec()
+	{
+#ifdef ARCHIVE_WITH_ZSTD
+		return GetCodec(CodecId::Zstd);
+#else
+		return GetCodec(CodecId::Deflate);
+#endif
+	}
+
+	std::optional<CodecId> m_fixed;
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include "../lib/osWrappers/FileDesc.h"
+#include <fcntl.h>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+inline FileDesc OpenFile(std::string const& path, const int flags, const mode_t mode = 0644)
+{
+	const int desc = open(path.c_str(), flags | O_CLOEXEC, mode);
+	if (desc == -1)
+	{
+		throw std::system_error(errno, std::generic_category(), "Error opening " + path);
+	}
+	return FileDesc(desc);
+}
+
+inline std::vector<char> ReadFileContent(std::string const& path)
+{
+	auto file = OpenFile(path, O_RDONLY);
+	struct stat st{};
+	if (fstat(file.Get(), &st) != 0)
+	{
+		throw std::system_error(errno, std::generic_category(), "Error reading " + path);
+	}
+
+	std::vector<char> content(static_cast<size_t>(st.st_size));
+	size_t size = 0;
+	while (true)
+	{
+		if (size == content.size())
+		{
+			// файл мог вырасти после fstat
+			char probe[4096];
+			const auto bytesRead = file.Read(probe, sizeof(probe));
+			if (bytesRead == 0)
+			{
+				break;
+			}
+			content.insert(content.end(), probe, probe + bytesRead);
+			size += bytesRead;
+			continue;
+		}
+		const auto bytesRead = file.Read(content.data() + size, content.size() - size);
+		if (bytesRead == 0)
+		{
+			break;
+		}
+		size += bytesRead;
+	}
+	content.resize(size);
+
+	return content;
+}
+
+inline std::vector<char> ReadFileRange(FileDesc const& file, const uint64_t offset, const size_t size)
+{
+	std::vector<char> content(size);
+	size_t done = 0;
+	while (done < size)
+	{
+		const auto bytesRead = pread(file.Get(), content.data() + done, size - done, static_cast<off_t>(offset + done));
+		if (bytesRead == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			throw std::system_error(errno, std::generic_category(), "Error reading file");
+		}
+		if (bytesRead == 0)
+		{
+			break;
+		}
+		done += static_cast<size_t>(bytesRead);
+	}
+	content.resize(done);
+
+	return content;
+}
+
+inline void WriteFileContent(std::string const& path, std::span<const char> content)
+{
+	auto file = OpenFile(path, O_WRONLY | O_CREAT | O_TRUNC);
+	file.Write(content.data(), content.size());
+	file.Close();
+}
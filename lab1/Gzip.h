@@ -1,21 +1,232 @@
 #pragma once
-#include <vector>
+#include "FileContent.h"
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <span>
 #include <string>
 #include <stdexcept>
+#include <vector>
+#include <zlib.h>
+
+// 15 + 16: окно 32K и gzip-заголовок вместо zlib-заголовка
+constexpr int GZIP_WINDOW_BITS = 15 + 16;
+// 15 + 32: автоопределение gzip/zlib заголовка при распаковке
+constexpr int GUNZIP_WINDOW_BITS = 15 + 32;
+
+// flush = Z_FINISH завершает поток, Z_SYNC_FLUSH выравнивает его на границу байта для склейки блоков
+inline std::vector<char> RunDeflate(z_stream& stream, std::span<const char> data, const int flush)
+{
+	std::vector<char> result(deflateBound(&stream, data.size()) + 16);
+	size_t consumed = 0;
+	size_t produced = 0;
+	while (true)
+	{
+		const auto inChunk = std::min<size_t>(data.size() - consumed, UINT_MAX);
+		stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + consumed));
+		stream.avail_in = static_cast<uInt>(inChunk);
+		if (produced == result.size())
+		{
+			result.resize(result.size() * 2 + 64);
+		}
+		const auto outChunk = std::min<size_t>(result.size() - produced, UINT_MAX);
+		stream.next_out = reinterpret_cast<Bytef*>(result.data() + produced);
+		stream.avail_out = static_cast<uInt>(outChunk);
+
+		const bool last = consumed + inChunk == data.size();
+		const auto status = deflate(&stream, last ? flush : Z_NO_FLUSH);
+		consumed += inChunk - stream.avail_in;
+		produced += outChunk - stream.avail_out;
+		if (status == Z_STREAM_ERROR)
+		{
+			deflateEnd(&stream);
+			throw std::runtime_error("Error compressing data");
+		}
+		if (last && (flush == Z_FINISH ? status == Z_STREAM_END : stream.avail_in == 0 && stream.avail_out != 0))
+		{
+			break;
+		}
+	}
+	deflateEnd(&stream);
+	result.resize(produced);
+
+	return result;
+}
+
+inline std::vector<char> GzipCompress(std::span<const char> data, const int level = Z_DEFAULT_COMPRESSION)
+{
+	z_stream stream{};
+	if (deflateInit2(&stream, level, Z_DEFLATED, GZIP_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		throw std::runtime_error("Error initializing deflate");
+	}
+
+	return RunDeflate(stream, data, Z_FINISH);
+}
+
+// Сжимает один блок большого файла в сырой deflate, используя хвост предыдущего блока как словарь.
+// Блоки склеиваются между GzipHeader() и GzipTrailer() в один корректный gzip-поток
+inline std::vector<char> DeflateBlock(std::span<const char> data, std::span<const char> dictionary, const bool last,
+	const int level = Z_DEFAULT_COMPRESSION)
+{
+	z_stream stream{};
+	if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		throw std::runtime_error("Error initializing deflate");
+	}
+	if (!dictionary.empty()
+		&& deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.data()), static_cast<uInt>(dictionary.size())) != Z_OK)
+	{
+		deflateEnd(&stream);
+		throw std::runtime_error("Error setting deflate dictionary");
+	}
+
+	return RunDeflate(stream, data, last ? Z_FINISH : Z_SYNC_FLUSH);
+}
+
+inline std::array<char, 10> GzipHeader()
+{
+	// magic, deflate, без флагов, mtime = 0, xfl = 0, OS = Unix
+	return { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, 3 };
+}
+
+inline std::array<char, 8> GzipTrailer(const uLong crc, const uint64_t rawSize)
+{
+	std::array<char, 8> trailer{};
+	for (int i = 0; i < 4; ++i)
+	{
+		trailer[i] = static_cast<char>((crc >> (8 * i)) & 0xff);
+		trailer[i + 4] = static_cast<char>((rawSize >> (8 * i)) & 0xff);
+	}
+	return trailer;
+}
+
+// Распаковывает один или несколько склеенных gzip-членов. Всё после последнего члена, кроме следующего
+// полного члена, - ошибка: и мусор в конце, и обрезанный поток
+inline std::vector<char> GzipDecompress(std::span<const char> data)
+{
+	z_stream stream{};
+	if (inflateInit2(&stream, GUNZIP_WINDOW_BITS) != Z_OK)
+	{
+		throw std::runtime_error("Error initializing inflate");
+	}
+
+	std::vector<char> result(std::max<size_t>(data.size() * 4, 4096));
+	size_t consumed = 0;
+	size_t produced = 0;
+	while (true)
+	{
+		const auto inChunk = std::min<size_t>(data.size() - consumed, UINT_MAX);
+		stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + consumed));
+		stream.avail_in = static_cast<uInt>(inChunk);
+		if (produced == result.size())
+		{
+			result.resize(result.size() * 2);
+		}
+		const auto outChunk = std::min<size_t>(result.size() - produced, UINT_MAX);
+		stream.next_out = reinterpret_cast<Bytef*>(result.data() + produced);
+		stream.avail_out = static_cast<uInt>(outChunk);
+
+		const auto status = inflate(&stream, Z_NO_FLUSH);
+		consumed += inChunk - stream.avail_in;
+		produced += outChunk - stream.avail_out;
+		if (status == Z_STREAM_END)
+		{
+			if (consumed == data.size())
+			{
+				break;
+			}
+			// gzip допускает несколько склеенных членов в одном файле, остаток должен быть следующим членом
+			inflateReset(&stream);
+			continue;
+		}
 
-inline void GzipFile(std::string const& param, std::string const& filename)
+		const bool outputFull = stream.avail_out == 0;
+		if ((status != Z_OK && status != Z_BUF_ERROR) || (consumed == data.size() && !outputFull))
+		{
+			inflateEnd(&stream);
+			throw std::runtime_error(status == Z_DATA_ERROR
+					? "Invalid or trailing data in compressed stream"
+					: "Unexpected end of compressed data");
+		}
+	}
+	inflateEnd(&stream);
+	result.resize(produced);
+
+	return result;
+}
+
+// Потоковая распаковка диапазона входного файла (например, члена tar-архива) без загрузки его в память целиком
+inline void GunzipRangeToFile(FileDesc const& input, const uint64_t offset, const uint64_t size, std::string const& outputPath)
 {
-	const std::string command = "gzip " + param + " " + filename;
-	if (system(command.c_str()) != 0)
+	constexpr size_t chunkSize = 256 * 1024;
+	auto output = OpenFile(outputPath, O_WRONLY | O_CREAT | O_TRUNC);
+	z_stream stream{};
+	if (inflateInit2(&stream, GUNZIP_WINDOW_BITS) != Z_OK)
+	{
+		throw std::runtime_error("Error initializing inflate");
+	}
+
+	std::vector<char> outChunk(chunkSize);
+	uint64_t consumed = 0;
+	int status = Z_OK;
+	try
 	{
-		throw std::runtime_error("Error generating gzip file");
+		while (consumed < size)
+		{
+			const auto inChunk = ReadFileRange(input, offset + consumed, std::min<uint64_t>(size - consumed, chunkSize));
+			if (inChunk.empty())
+			{
+				throw std::runtime_error("Unexpected end of archive while reading " + outputPath);
+			}
+			consumed += inChunk.size();
+			stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(inChunk.data()));
+			stream.avail_in = static_cast<uInt>(inChunk.size());
+			do
+			{
+				stream.next_out = reinterpret_cast<Bytef*>(outChunk.data());
+				stream.avail_out = static_cast<uInt>(outChunk.size());
+				status = inflate(&stream, Z_NO_FLUSH);
+				if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+				{
+					throw std::runtime_error("Error decompressing " + outputPath);
+				}
+				output.Write(outChunk.data(), outChunk.size() - stream.avail_out);
+				if (status == Z_STREAM_END && stream.avail_in != 0)
+				{
+					// следующий склеенный gzip-член
+					inflateReset(&stream);
+				}
+			} while (status != Z_BUF_ERROR && (stream.avail_out == 0 || stream.avail_in != 0));
+		}
+		if (status != Z_STREAM_END)
+		{
+			throw std::runtime_error("Unexpected end of compressed data in " + outputPath);
+		}
 	}
+	catch (...)
+	{
+		inflateEnd(&stream);
+		throw;
+	}
+	inflateEnd(&stream);
+	output.Close();
+}
+
+inline void GunzipFile(std::string const& file)
+{
+	const auto content = ReadFileContent(file);
+	const auto outputFile = file.ends_with(".gz") ? file.substr(0, file.size() - 3) : file + ".out";
+	WriteFileContent(outputFile, GzipDecompress(content));
+	std::remove(file.c_str());
 }
 
-inline void GzipFiles(std::string const& param, std::vector<std::string> const& files)
+inline void GunzipFiles(std::vector<std::string> const& files)
 {
 	for (const auto& file : files)
 	{
-		GzipFile(param, file);
+		GunzipFile(file);
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "ArchiveIndex.h"
+#include "ArchiveWriter.h"
+#include "WorkerPool.h"
+#include <filesystem>
+#include <future>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct IncrementalStats
+{
+	size_t reusedFiles = 0;
+	uint64_t reusedBytes = 0;
+	size_t compressedFiles = 0;
+};
+
+// Файлы, чьи размер и XXH64 совпали с членом предыдущего архива, копируются из него в сжатом виде,
+// остальные сжимаются заново. Совпадение ищется по содержимому, поэтому переименованные файлы тоже не пересжимаются.
+// Архив со старым индексом без хешей (ARCIDX02) годится как база, но из него ничего не переиспользуется.
+// Перенесённые члены идут через ту же упорядоченную очередь, что и сжимаемые, поэтому порядок files сохраняется.
+// Заранее читаются только файлы с размером как у какого-нибудь члена базы, и хешируются так же, как при сжатии (HashFileContent).
+// В индекс нового архива хеш попадает из буферов сжатия или из базы, то есть всегда соответствует сохранённым данным
+template <typename Pool>
+IncrementalStats WriteIncrementalArchive(std::string const& archivePath, std::vector<std::string> const& files, std::string const& baseArchivePath,
+	Pool& pool, const size_t maxInFlight, CodecSelector const& selector)
+{
+	if (std::filesystem::exists(archivePath) && std::filesystem::equivalent(archivePath, baseArchivePath))
+	{
+		throw std::invalid_argument("Incremental base must differ from the output archive");
+	}
+	const auto base = OpenFile(baseArchivePath, O_RDONLY);
+	const auto baseIndex = ReadIndex(base);
+	if (!baseIndex)
+	{
+		throw std::runtime_error("Archive has no index: " + baseArchivePath);
+	}
+	std::unordered_map<uint64_t, IndexEntry const*> baseByHash;
+	std::unordered_set<uint64_t> baseSizes;
+	for (const auto& entry : *baseIndex)
+	{
+		if (entry.contentHash != 0)
+		{
+			baseByHash.emplace(entry.contentHash, &entry);
+			baseSizes.insert(entry.rawSize);
+		}
+	}
+
+	// хеширование упирается в чтение, а не в процессор, поэтому идёт потоками даже при сжатии в процессах
+	WorkerPool hashPool(std::max(1u, std::thread::hardware_concurrency()));
+	std::vector<std::future<std::optional<uint64_t>>> hashes;
+	hashes.reserve(files.size());
+	for (const auto& file : files)
+	{
+		hashes.push_back(hashPool.Submit([&file, &baseSizes]() -> std::optional<uint64_t> {
+			if (!baseSizes.contains(GetFileInfo(file).size))
+			{
+				return std::nullopt;
+			}
+			return HashFileContent(file);
+		}));
+	}
+
+	IncrementalStats stats;
+	std::unordered_map<std::string, IndexEntry const*> reused;
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		const auto& file = files[i];
+		const auto hash = hashes[i].get();
+		const auto it = hash ? baseByHash.find(*hash) : baseByHash.end();
+		if (it != baseByHash.end() && it->second->rawSize == GetFileInfo(file).size)
+		{
+			reused.emplace(file, it->second);
+			++stats.reusedFiles;
+			stats.reusedBytes += it->second->rawSize;
+		}
+		else
+		{
+			++stats.compressedFiles;
+		}
+	}
+
+	auto output = OpenFile(archivePath, O_WRONLY | O_CREAT | O_TRUNC);
+	TarWriter writer(output);
+	ArchiveSink sink(writer);
+	sink.SetReusedMembers(base, std::move(reused));
+	CompressFilesOrdered(files, selector, pool, maxInFlight, sink);
+	sink.WriteIndex();
+	writer.Finish();
+	output.Close();
+
+	return stats;
+}
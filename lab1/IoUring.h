@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <liburing.h>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <sys/uio.h>
+#include <system_error>
+
+// Владеет кольцом io_uring. Постановка заданий и разбор завершений могут идти из разных потоков,
+// но каждая из сторон - только из одного потока
+class IoUring
+{
+public:
+	struct Completion
+	{
+		uint64_t userData;
+		int result;
+	};
+
+	explicit IoUring(const unsigned entries)
+	{
+		if (const auto error = io_uring_queue_init(entries, &m_ring, 0); error < 0)
+		{
+			throw std::system_error(-error, std::generic_category(), "Error initializing io_uring");
+		}
+	}
+
+	IoUring(const IoUring&) = delete;
+	IoUring& operator=(const IoUring&) = delete;
+
+	~IoUring()
+	{
+		io_uring_queue_exit(&m_ring);
+	}
+
+	// Зарегистрированные буферы ядро отображает один раз, а не при каждом чтении и записи
+	void RegisterBuffers(std::span<const iovec> buffers)
+	{
+		if (const auto error = io_uring_register_buffers(&m_ring, buffers.data(), static_cast<unsigned>(buffers.size())); error < 0)
+		{
+			throw std::system_error(-error, std::generic_category(), "Error registering io_uring buffers");
+		}
+	}
+
+	io_uring_sqe& GetSqe()
+	{
+		auto* sqe = io_uring_get_sqe(&m_ring);
+		if (!sqe)
+		{
+			Submit();
+			sqe = io_uring_get_sqe(&m_ring);
+		}
+		if (!sqe)
+		{
+			throw std::runtime_error("io_uring submission queue is full");
+		}
+		return *sqe;
+	}
+
+	void Submit()
+	{
+		if (const auto error = io_uring_submit(&m_ring); error < 0)
+		{
+			throw std::system_error(-error, std::generic_category(), "Error submitting io_uring requests");
+		}
+	}
+
+	Completion WaitCompletion()
+	{
+		io_uring_cqe* cqe = nullptr;
+		int error;
+		while ((error = io_uring_wait_cqe(&m_ring, &cqe)) == -EINTR)
+		{
+		}
+		if (error < 0)
+		{
+			throw std::system_error(-error, std::generic_category(), "Error waiting for io_uring completion");
+		}
+		const Completion completion{ io_uring_cqe_get_data64(cqe), cqe->res };
+		io_uring_cqe_seen(&m_ring, cqe);
+		return completion;
+	}
+
+private:
+	io_uring m_ring{};
+};
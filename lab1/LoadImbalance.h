@@ -0,0 +1,31 @@
+#pragma once
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Отношение максимальной нагрузки к средней: 1.0 - все исполнители заканчивают одновременно
+template <typename T>
+void PrintLoadImbalance(std::ostream& output, std::string const& name, std::vector<T> const& loads, std::string const& unit)
+{
+	if (loads.empty())
+	{
+		return;
+	}
+	const auto total = std::accumulate(loads.begin(), loads.end(), 0.0);
+	const auto mean = total / static_cast<double>(loads.size());
+	const auto [min, max] = std::ranges::minmax(loads);
+
+	const auto precision = output.precision();
+	output << name << " load per worker (" << unit << "):";
+	for (const auto load : loads)
+	{
+		output << ' ' << load;
+	}
+	output << std::endl
+		   << name << " imbalance: min " << min << ", max " << max
+		   << ", max/mean " << std::fixed << std::setprecision(2) << (mean > 0 ? static_cast<double>(max) / mean : 1.0)
+		   << std::defaultfloat << std::setprecision(static_cast<int>(precision)) << std::endl;
+}
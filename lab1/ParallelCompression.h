@@ -0,0 +1,290 @@
+#pragma once
+#include "Codec.h"
+#include "CodecSelector.h"
+#include "FileContent.h"
+#include "WorkerPool.h"
+#include "XxHash64.h"
+#include <array>
+#include <deque>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Файлы больше двух блоков сжимаются параллельно по блокам (как pigz)
+constexpr size_t COMPRESSION_BLOCK_SIZE = 1 << 20;
+constexpr size_t COMPRESSION_DICTIONARY_SIZE = 32 * 1024;
+
+inline bool IsCompressedByBlocks(const uint64_t fileSize)
+{
+	return fileSize > 2 * COMPRESSION_BLOCK_SIZE;
+}
+
+inline uint64_t HashContent(std::span<const char> content)
+{
+	XxHash64 hash;
+	hash.Update(content);
+	return hash.Digest();
+}
+
+// Хеш содержимого для индекса считается по тем же буферам, что и сжатие: у целого файла это XXH64 содержимого,
+// у файла по блокам - XXH64 от XXH64 его блоков по порядку (little-endian), потому что блоки хешируются разными потоками
+class BlockHashes
+{
+public:
+	void Add(const uint64_t blockHash)
+	{
+		std::array<char, sizeof(blockHash)> bytes{};
+		for (size_t i = 0; i < bytes.size(); ++i)
+		{
+			bytes[i] = static_cast<char>(blockHash >> (8 * i));
+		}
+		m_hash.Update(bytes);
+	}
+
+	[[nodiscard]] uint64_t Digest() const
+	{
+		return m_hash.Digest();
+	}
+
+private:
+	XxHash64 m_hash;
+};
+
+struct FileInfo
+{
+	std::string name;
+	uint64_t size;
+	mode_t mode;
+	time_t mtime;
+};
+
+inline FileInfo GetFileInfo(std::string const& file)
+{
+	struct stat st{};
+	if (stat(file.c_str(), &st) != 0)
+	{
+		throw std::system_error(errno, std::generic_category(), "Error reading " + file);
+	}
+	return {
+		.name = file,
+		.size = static_cast<uint64_t>(st.st_size),
+		.mode = st.st_mode,
+		.mtime = st.st_mtime,
+	};
+}
+
+struct CompressedBlock
+{
+	Codec const* codec = nullptr;
+	std::vector<char> data{};
+	uLong crc = 0;
+	size_t rawSize = 0;
+	// HashContent несжатых данных блока
+	uint64_t contentHash = 0;
+};
+
+inline CompressedBlock CompressContent(std::span<const char> content, CodecSelector const& selector)
+{
+	auto const& codec = selector.Select(content);
+	return {
+		.codec = &codec,
+		.data = codec.Compress(content),
+		.crc = crc32_z(crc32(0, nullptr, 0), reinterpret_cast<const Bytef*>(content.data()), content.size()),
+		.rawSize = content.size(),
+		.contentHash = HashContent(content),
+	};
+}
+
+inline CompressedBlock CompressWholeFile(std::string const& file, CodecSelector const& selector)
+{
+	return CompressContent(ReadFileContent(file), selector);
+}
+
+// content - блок вместе с предшествующим ему словарём длины dictionarySize
+inline CompressedBlock CompressBlockContent(Codec const& codec, std::span<const char> content, const size_t dictionarySize, const bool last)
+{
+	const auto dictionary = content.first(dictionarySize);
+	const auto data = content.subspan(dictionarySize);
+
+	return {
+		.codec = &codec,
+		.data = codec.CompressBlock(data, dictionary, last),
+		.crc = crc32_z(crc32(0, nullptr, 0), reinterpret_cast<const Bytef*>(data.data()), data.size()),
+		.rawSize = data.size(),
+		.contentHash = HashContent(data),
+	};
+}
+
+inline uint64_t GetDictionaryStart(const uint64_t blockStart)
+{
+	return blockStart - std::min<uint64_t>(blockStart, COMPRESSION_DICTIONARY_SIZE);
+}
+
+inline CompressedBlock CompressFileBlock(Codec const& codec, FileDesc const& file, const uint64_t blockStart, const uint64_t blockEnd, const bool last)
+{
+	const auto dictionaryStart = GetDictionaryStart(blockStart);
+	const auto content = ReadFileRange(file, dictionaryStart, blockEnd - dictionaryStart);
+	return CompressBlockContent(codec, content, blockStart - dictionaryStart, last);
+}
+
+// Тот же хеш, что CompressFilesOrdered отдаёт в sink, но отдельным чтением файла
+inline uint64_t HashFileContent(std::string const& file)
+{
+	const auto desc = OpenFile(file, O_RDONLY);
+	const auto size = GetFileInfo(file).size;
+	if (!IsCompressedByBlocks(size))
+	{
+		return HashContent(ReadFileRange(desc, 0, size));
+	}
+	BlockHashes hashes;
+	for (uint64_t offset = 0; offset < size; offset += COMPRESSION_BLOCK_SIZE)
+	{
+		hashes.Add(HashContent(ReadFileRange(desc, offset, std::min<uint64_t>(COMPRESSION_BLOCK_SIZE, size - offset))));
+	}
+	return hashes.Digest();
+}
+
+// Задание на сжатие целого файла или блока. Описывается только именем файла и числами,
+// поэтому может выполняться как потоком, так и другим процессом (ProcessCompression.h)
+struct CompressionTask
+{
+	std::string file{};
+	// nullopt - codec выбирается по содержимому, только для целого файла
+	std::optional<CodecId> codec;
+	bool wholeFile = true;
+	uint64_t blockStart = 0;
+	// для целого файла - его размер на момент постановки задания
+	uint64_t blockEnd = 0;
+	bool last = true;
+};
+
+inline CompressedBlock RunCompressionTask(CompressionTask const& task)
+{
+	try
+	{
+		if (task.wholeFile)
+		{
+			return CompressWholeFile(task.file, CodecSelector(task.codec));
+		}
+		const auto desc = OpenFile(task.file, O_RDONLY);
+		return CompressFileBlock(GetCodec(task.codec.value()), desc, task.blockStart, task.blockEnd, task.last);
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error("Error compressing " + task.file + ": " + e.what());
+	}
+}
+
+inline std::future<CompressedBlock> SubmitCompression(WorkerPool& pool, CompressionTask task)
+{
+	return pool.Submit([task = std::move(task)] {
+		return RunCompressionTask(task);
+	});
+}
+
+// Результаты отдаются в sink в порядке files, одновременно в работе не больше maxInFlight файлов или блоков.
+// Маленькие файлы приходят целиком в sink.AddFile, большие - через BeginFile/AppendData/EndFile.
+// Вместе с данными sink получает codec, CRC32, размер и хеш несжатого содержимого.
+// Файл, для которого sink.IsReused, не сжимается: в свою очередь sink сам переносит его член через CopyReusedFile
+// Pool - WorkerPool или ProcessPool, задания отправляются через перегрузку SubmitCompression
+template <typename Pool, typename Sink>
+void CompressFilesOrdered(std::vector<std::string> const& files, CodecSelector const& selector, Pool& pool, const size_t maxInFlight, Sink& sink)
+{
+	struct Pending
+	{
+		FileInfo info;
+		size_t blockIndex;
+		size_t blocksNum;
+		std::future<CompressedBlock> result;
+		// член уже есть у sink (инкрементальный архив), сжимать нечего
+		bool reused = false;
+	};
+
+	std::deque<Pending> inFlight;
+	uLong crc = 0;
+	uint64_t rawSize = 0;
+	BlockHashes hashes;
+
+	auto consume = [&] {
+		auto pending = std::move(inFlight.front());
+		inFlight.pop_front();
+		if (pending.reused)
+		{
+			sink.CopyReusedFile(pending.info);
+			return;
+		}
+		const auto block = pending.result.get();
+		if (pending.blocksNum == 0)
+		{
+			sink.AddFile(pending.info, block);
+			return;
+		}
+
+		if (pending.blockIndex == 0)
+		{
+			sink.BeginFile(pending.info, *block.codec);
+			sink.AppendData(block.codec->StreamHeader());
+			crc = crc32(0, nullptr, 0);
+			rawSize = 0;
+			hashes = {};
+		}
+		sink.AppendData(block.data);
+		crc = crc32_combine(crc, block.crc, static_cast<z_off_t>(block.rawSize));
+		rawSize += block.rawSize;
+		hashes.Add(block.contentHash);
+		if (pending.blockIndex + 1 == pending.blocksNum)
+		{
+			sink.AppendData(block.codec->StreamTrailer(crc, rawSize));
+			sink.EndFile(pending.info, crc, rawSize, hashes.Digest());
+		}
+	};
+
+	auto reserveSlot = [&] {
+		while (inFlight.size() >= std::max<size_t>(maxInFlight, 1))
+		{
+			consume();
+		}
+	};
+	auto submit = [&](FileInfo const& info, const size_t blockIndex, const size_t blocksNum, CompressionTask task) {
+		reserveSlot();
+		inFlight.push_back({ info, blockIndex, blocksNum, SubmitCompression(pool, std::move(task)) });
+	};
+
+	for (const auto& file : files)
+	{
+		const auto info = GetFileInfo(file);
+		if (sink.IsReused(info))
+		{
+			reserveSlot();
+			inFlight.push_back({ .info = info, .blockIndex = 0, .blocksNum = 0, .result = {}, .reused = true });
+			continue;
+		}
+		if (!IsCompressedByBlocks(info.size))
+		{
+			submit(info, 0, 0, { .file = file, .codec = selector.GetFixedCodec(), .blockEnd = info.size });
+			continue;
+		}
+
+		const auto codec = selector.Select(OpenFile(file, O_RDONLY), info.size).GetId();
+		const auto blocksNum = (info.size + COMPRESSION_BLOCK_SIZE - 1) / COMPRESSION_BLOCK_SIZE;
+		for (size_t i = 0; i < blocksNum; ++i)
+		{
+			const auto blockStart = i * COMPRESSION_BLOCK_SIZE;
+			submit(info, i, blocksNum, {
+				.file = file,
+				.codec = codec,
+				.wholeFile = false,
+				.blockStart = blockStart,
+				.blockEnd = std::min<uint64_t>(blockStart + COMPRESSION_BLOCK_SIZE, info.size),
+				.last = i + 1 == blocksNum,
+			});
+		}
+	}
+
+	while (!inFlight.empty())
+	{
+		consume();
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "ByteOrder.h"
+#include "Codec.h"
+#include "ParallelCompression.h"
+#include "ProcessPool.h"
+#include <future>
+#include <span>
+#include <string>
+#include <vector>
+
+// Скрытый режим make-archive, в котором он работает рабочим процессом ProcessPool
+inline const std::string COMPRESSION_WORKER_ARG = "--compression-worker";
+
+constexpr uint8_t AUTO_CODEC_ID = 0xff;
+
+inline std::vector<char> SerializeCompressionTask(CompressionTask const& task)
+{
+	std::vector<char> result;
+	AppendLittleEndian<uint8_t>(result, task.codec ? static_cast<uint8_t>(*task.codec) : AUTO_CODEC_ID);
+	AppendLittleEndian<uint8_t>(result, task.wholeFile);
+	AppendLittleEndian<uint8_t>(result, task.last);
+	AppendLittleEndian<uint64_t>(result, task.blockStart);
+	AppendLittleEndian<uint64_t>(result, task.blockEnd);
+	result.insert(result.end(), task.file.begin(), task.file.end());
+	return result;
+}
+
+inline CompressionTask ParseCompressionTask(std::span<const char> data)
+{
+	size_t pos = 0;
+	const auto codec = ReadLittleEndian<uint8_t>(data, pos);
+	CompressionTask task{
+		.codec = codec == AUTO_CODEC_ID ? std::nullopt : std::optional(static_cast<CodecId>(codec)),
+		.wholeFile = ReadLittleEndian<uint8_t>(data, pos) != 0,
+	};
+	task.last = ReadLittleEndian<uint8_t>(data, pos) != 0;
+	task.blockStart = ReadLittleEndian<uint64_t>(data, pos);
+	task.blockEnd = ReadLittleEndian<uint64_t>(data, pos);
+	task.file.assign(data.begin() + static_cast<std::ptrdiff_t>(pos), data.end());
+	return task;
+}
+
+// Служебные поля идут после сжатых данных: родитель отрезает их, не сдвигая данные
+constexpr size_t COMPRESSED_BLOCK_TRAILER_SIZE = 1 + 4 + 8 + 8;
+
+inline std::vector<char> SerializeCompressedBlock(CompressedBlock block)
+{
+	auto result = std::move(block.data);
+	AppendLittleEndian<uint8_t>(result, static_cast<uint8_t>(block.codec->GetId()));
+	AppendLittleEndian<uint32_t>(result, static_cast<uint32_t>(block.crc));
+	AppendLittleEndian<uint64_t>(result, block.rawSize);
+	AppendLittleEndian<uint64_t>(result, block.contentHash);
+	return result;
+}
+
+inline CompressedBlock ParseCompressedBlock(std::vector<char> data)
+{
+	if (data.size() < COMPRESSED_BLOCK_TRAILER_SIZE)
+	{
+		throw std::runtime_error("Invalid compressed block from worker process");
+	}
+	size_t pos = data.size() - COMPRESSED_BLOCK_TRAILER_SIZE;
+	CompressedBlock block{ .codec = &GetCodec(static_cast<CodecId>(ReadLittleEndian<uint8_t>(data, pos))) };
+	block.crc = ReadLittleEndian<uint32_t>(data, pos);
+	block.rawSize = ReadLittleEndian<uint64_t>(data, pos);
+	block.contentHash = ReadLittleEndian<uint64_t>(data, pos);
+	data.resize(data.size() - COMPRESSED_BLOCK_TRAILER_SIZE);
+	block.data = std::move(data);
+	return block;
+}
+
+// Стоимость задания для балансировки - размер входа. Результат разбирается лениво в потоке, который ждёт future
+inline std::future<CompressedBlock> SubmitCompression(ProcessPool& pool, CompressionTask const& task)
+{
+	const auto cost = std::max<uint64_t>(task.blockEnd - task.blockStart, 1);
+	return std::async(std::launch::deferred, [response = pool.Submit(SerializeCompressionTask(task), cost)]() mutable {
+		return ParseCompressedBlock(response.get());
+	});
+}
+
+inline int RunCompressionWorker()
+{
+	return RunProcessPoolWorker([](std::span<const char> request) {
+		return SerializeCompressedBlock(RunCompressionTask(ParseCompressionTask(request)));
+	});
+}
@@ -0,0 +1,351 @@
+#pragma once
+#include "../lib/osWrappers/FileDesc.h"
+#include "ByteOrder.h"
+#include <csignal>
+#include <cstdint>
+#include <deque>
+#include <fcntl.h>
+#include <future>
+#include <iostream>
+#include <gsl/gsl>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <spawn.h>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Сообщение в pipe: [u32 длина][данные]. Ответ рабочего процесса: [u8 статус][результат или текст ошибки]
+namespace process_pool
+{
+constexpr uint8_t STATUS_OK = 0;
+constexpr uint8_t STATUS_ERROR = 1;
+
+inline bool ReadExact(FileDesc& input, char* buffer, const size_t length)
+{
+	size_t done = 0;
+	while (done < length)
+	{
+		const auto bytesRead = input.Read(buffer + done, length - done);
+		if (bytesRead == 0)
+		{
+			if (done == 0)
+			{
+				return false;
+			}
+			throw std::runtime_error("Unexpected end of pipe");
+		}
+		done += bytesRead;
+	}
+	return true;
+}
+
+// nullopt - другая сторона закрыла pipe
+inline std::optional<std::vector<char>> ReadMessage(FileDesc& input)
+{
+	char header[sizeof(uint32_t)];
+	if (!ReadExact(input, header, sizeof(header)))
+	{
+		return std::nullopt;
+	}
+	size_t pos = 0;
+	std::vector<char> message(ReadLittleEndian<uint32_t>(header, pos));
+	if (!message.empty() && !ReadExact(input, message.data(), message.size()))
+	{
+		throw std::runtime_error("Unexpected end of pipe");
+	}
+	return message;
+}
+
+inline void WriteMessage(FileDesc& output, std::span<const char> prefix, std::span<const char> message)
+{
+	if (prefix.size() + message.size() > UINT32_MAX)
+	{
+		throw std::length_error("Message is too long for pipe");
+	}
+	std::vector<char> header;
+	AppendLittleEndian<uint32_t>(header, static_cast<uint32_t>(prefix.size() + message.size()));
+	header.insert(header.end(), prefix.begin(), prefix.end());
+	output.Write(header.data(), header.size());
+	output.Write(message.data(), message.size());
+}
+
+// Статус отделяется от результата без копирования многомегабайтных данных
+inline std::optional<std::pair<uint8_t, std::vector<char>>> ReadResponse(FileDesc& input)
+{
+	char header[sizeof(uint32_t) + 1];
+	if (!ReadExact(input, header, sizeof(header)))
+	{
+		return std::nullopt;
+	}
+	size_t pos = 0;
+	const auto size = ReadLittleEndian<uint32_t>(header, pos);
+	if (size == 0)
+	{
+		throw std::runtime_error("Invalid response from worker process");
+	}
+	std::vector<char> payload(size - 1);
+	if (!payload.empty() && !ReadExact(input, payload.data(), payload.size()))
+	{
+		throw std::runtime_error("Unexpected end of pipe");
+	}
+	return std::pair{ static_cast<uint8_t>(header[sizeof(uint32_t)]), std::move(payload) };
+}
+} // namespace process_pool
+
+// Долгоживущие рабочие процессы, порождённые posix_spawn (в glibc это clone(CLONE_VM | CLONE_VFORK) без копирования
+// таблиц страниц родителя). Задания и результаты передаются через stdin/stdout рабочего процесса,
+// поэтому стоимость запуска платится один раз за прогон, а не за каждую порцию файлов
+class ProcessPool
+{
+public:
+	ProcessPool(std::string const& executable, std::vector<std::string> const& args, const unsigned processesNum)
+	{
+		// запись в pipe умершего рабочего должна давать EPIPE, а не завершать архиватор
+		std::signal(SIGPIPE, SIG_IGN);
+		try
+		{
+			for (unsigned i = 0; i < std::max(processesNum, 1u); ++i)
+			{
+				m_workers.push_back(Spawn(executable, args));
+			}
+		}
+		catch (...)
+		{
+			Shutdown();
+			throw;
+		}
+		for (auto& worker : m_workers)
+		{
+			worker->reader = std::jthread([this, &worker = *worker] {
+				ReadResponses(worker);
+			});
+		}
+	}
+
+	ProcessPool(const ProcessPool&) = delete;
+	ProcessPool& operator=(const ProcessPool&) = delete;
+
+	~ProcessPool()
+	{
+		Shutdown();
+	}
+
+	[[nodiscard]] unsigned GetProcessesNum() const
+	{
+		return static_cast<unsigned>(m_workers.size());
+	}
+
+	// Суммарная стоимость выполненных каждым процессом заданий, для оценки дисбаланса нагрузки
+	[[nodiscard]] std::vector<uint64_t> GetCompletedCosts() const
+	{
+		std::lock_guard lock(m_mutex);
+		std::vector<uint64_t> result;
+		for (const auto& worker : m_workers)
+		{
+			result.push_back(worker->completedCost);
+		}
+		return result;
+	}
+
+	// Задание уходит процессу с наименьшей суммарной стоимостью очереди (например, в байтах входа),
+	// так что несколько больших заданий не скапливаются у одного процесса.
+	// Ошибка задания в рабочем процессе приходит исключением из future
+	std::future<std::vector<char>> Submit(std::span<const char> request, const uint64_t cost = 1)
+	{
+		std::unique_lock lock(m_mutex);
+		Worker* target = nullptr;
+		for (const auto& worker : m_workers)
+		{
+			if (!worker->exited && (!target || worker->pendingCost < target->pendingCost))
+			{
+				target = worker.get();
+			}
+		}
+		if (!target)
+		{
+			throw std::runtime_error("All worker processes have exited");
+		}
+
+		// запись в pipe может заблокироваться, пока рабочий занят, поэтому идёт без общего мьютекса,
+		// чтобы поток чтения ответов не встал. Порядок записей совпадает с порядком pending
+		std::lock_guard writeLock(target->writeMutex);
+		auto future = target->pending.emplace_back(std::promise<std::vector<char>>(), cost).first.get_future();
+		target->pendingCost += cost;
+		lock.unlock();
+		// если рабочий умер, его поток чтения завершит future исключением
+		process_pool::WriteMessage(target->requests, {}, request);
+		return future;
+	}
+
+private:
+	struct Worker
+	{
+		pid_t pid = -1;
+		FileDesc requests;
+		std::mutex writeMutex;
+		FileDesc responses;
+		// обещание и стоимость задания
+		std::deque<std::pair<std::promise<std::vector<char>>, uint64_t>> pending;
+		uint64_t pendingCost = 0;
+		uint64_t completedCost = 0;
+		bool exited = false;
+		std::jthread reader;
+	};
+
+	void Shutdown()
+	{
+		// EOF на stdin - сигнал рабочему завершиться после текущих заданий
+		for (auto& worker : m_workers)
+		{
+			try
+			{
+				worker->requests.Close();
+			}
+			catch (...)
+			{
+			}
+		}
+		for (auto& worker : m_workers)
+		{
+			if (worker->reader.joinable())
+			{
+				worker->reader.join();
+			}
+			waitpid(worker->pid, nullptr, 0);
+		}
+	}
+
+	static std::pair<FileDesc, FileDesc> MakePipe()
+	{
+		// O_CLOEXEC, чтобы рабочие не унаследовали чужие концы pipe и вовремя получали EOF
+		int fds[2];
+		if (pipe2(fds, O_CLOEXEC) != 0)
+		{
+			throw std::system_error(errno, std::generic_category(), "Error creating pipe");
+		}
+		return { FileDesc(fds[0]), FileDesc(fds[1]) };
+	}
+
+	static std::unique_ptr<Worker> Spawn(std::string const& executable, std::vector<std::string> const& args)
+	{
+		auto [requestsRead, requestsWrite] = MakePipe();
+		auto [responsesRead, responsesWrite] = MakePipe();
+
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init(&actions);
+		auto destroyActions = gsl::finally([&] {
+			posix_spawn_file_actions_destroy(&actions);
+		});
+		posix_spawn_file_actions_adddup2(&actions, requestsRead.Get(), STDIN_FILENO);
+		posix_spawn_file_actions_adddup2(&actions, responsesWrite.Get(), STDOUT_FILENO);
+
+		posix_spawnattr_t attr;
+		posix_spawnattr_init(&attr);
+		auto destroyAttr = gsl::finally([&] {
+			posix_spawnattr_destroy(&attr);
+		});
+		sigset_t defaultSignals;
+		sigemptyset(&defaultSignals);
+		sigaddset(&defaultSignals, SIGPIPE);
+		posix_spawnattr_setsigdefault(&attr, &defaultSignals);
+		posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+
+		std::vector<char*> argv{ const_cast<char*>(executable.c_str()) };
+		for (const auto& arg : args)
+		{
+			argv.push_back(const_cast<char*>(arg.c_str()));
+		}
+		argv.push_back(nullptr);
+
+		auto worker = std::make_unique<Worker>();
+		if (const auto error = posix_spawn(&worker->pid, executable.c_str(), &actions, &attr, argv.data(), environ); error != 0)
+		{
+			throw std::system_error(error, std::generic_category(), "Error spawning " + executable);
+		}
+		worker->requests = std::move(requestsWrite);
+		worker->responses = std::move(responsesRead);
+		return worker;
+	}
+
+	void ReadResponses(Worker& worker)
+	{
+		try
+		{
+			while (auto response = process_pool::ReadResponse(worker.responses))
+			{
+				auto& [status, payload] = *response;
+				std::lock_guard lock(m_mutex);
+				if (worker.pending.empty())
+				{
+					throw std::runtime_error("Unexpected response from worker process");
+				}
+				auto [promise, cost] = std::move(worker.pending.front());
+				worker.pending.pop_front();
+				worker.pendingCost -= cost;
+				worker.completedCost += cost;
+				if (status != process_pool::STATUS_OK)
+				{
+					promise.set_exception(std::make_exception_ptr(std::runtime_error(std::string(payload.begin(), payload.end()))));
+					continue;
+				}
+				promise.set_value(std::move(payload));
+			}
+		}
+		catch (...)
+		{
+		}
+
+		std::lock_guard lock(m_mutex);
+		worker.exited = true;
+		for (auto& [promise, cost] : worker.pending)
+		{
+			promise.set_exception(std::make_exception_ptr(std::runtime_error("Worker process " + std::to_string(worker.pid) + " exited unexpectedly")));
+		}
+		worker.pending.clear();
+		worker.pendingCost = 0;
+	}
+
+	mutable std::mutex m_mutex;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+};
+
+// Цикл рабочего процесса: задания читаются из stdin до EOF, результаты пишутся в stdout в том же порядке.
+// stdout занят протоколом, поэтому собственные ошибки рабочий пишет в stderr
+template <typename Handler>
+int RunProcessPoolWorker(Handler&& handler)
+{
+	try
+	{
+		FileDesc input(STDIN_FILENO);
+		FileDesc output(STDOUT_FILENO);
+		while (const auto request = process_pool::ReadMessage(input))
+		{
+			std::vector<char> response;
+			char status = process_pool::STATUS_OK;
+			try
+			{
+				response = handler(std::span<const char>(*request));
+			}
+			catch (const std::exception& e)
+			{
+				const std::string message = e.what();
+				response.assign(message.begin(), message.end());
+				status = process_pool::STATUS_ERROR;
+			}
+			process_pool::WriteMessage(output, { &status, 1 }, response);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,328 @@
+#pragma once
+#include "../lib/osWrappers/FileDesc.h"
+#include "TarWriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <sys/stat.h>
+#include <vector>
+
+// Больше pax-заголовки и GNU-имена не бывают на деле, а в испорченном архиве размер может быть любым
+constexpr uint64_t MAX_TAR_EXTENDED_HEADER_SIZE = 1 << 20;
+
+struct TarMember
+{
+	std::string name;
+	char type;
+	mode_t mode;
+	time_t mtime;
+	uint64_t size;
+	uint64_t dataOffset;
+	// значение pax-записи CODEC_PAX_KEY, если codec не следует из имени
+	std::optional<std::string> codec;
+};
+
+// Последовательно разбирает ustar/pax/GNU-архив по мере чтения из дескриптора, который может быть и pipe.
+// Непрочитанные данные текущего члена пропускаются при следующем Next()
+class TarReader
+{
+public:
+	explicit TarReader(FileDesc& input)
+		: m_input(input)
+		  , m_seekable(lseek(input.Get(), 0, SEEK_CUR) != -1)
+		  , m_offset(m_seekable ? static_cast<uint64_t>(lseek(input.Get(), 0, SEEK_CUR)) : 0)
+	{
+	}
+
+	TarReader(const TarReader&) = delete;
+	TarReader& operator=(const TarReader&) = delete;
+
+	[[nodiscard]] bool IsSeekable() const
+	{
+		return m_seekable;
+	}
+
+	std::optional<TarMember> Next()
+	{
+		Skip(m_remaining);
+		m_remaining = 0;
+
+		std::optional<std::string> longName;
+		std::optional<uint64_t> paxSize;
+		std::optional<std::string> codec;
+		while (true)
+		{
+			TarHeader header{};
+			if (!ReadExact(&header, sizeof(header)))
+			{
+				return std::nullopt;
+			}
+			if (IsZeroBlock(header))
+			{
+				return std::nullopt;
+			}
+			VerifyChecksum(header);
+
+			const auto size = ParseNumber(header.size, sizeof(header.size));
+			const auto paddedSize = (size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+			if (header.typeflag == 'x' || header.typeflag == 'L')
+			{
+				if (size > MAX_TAR_EXTENDED_HEADER_SIZE)
+				{
+					throw std::runtime_error("Tar extended header is too large");
+				}
+				std::string data(size, '\0');
+				ReadExactOrThrow(data.data(), data.size());
+				Skip(paddedSize - size);
+				if (header.typeflag == 'L')
+				{
+					longName = data.substr(0, data.find('\0'));
+				}
+				else
+				{
+					ParsePaxRecords(data, longName, paxSize, codec);
+				}
+				continue;
+			}
+			if (header.typeflag == 'g')
+			{
+				Skip(paddedSize);
+				continue;
+			}
+
+			TarMember member{
+				.name = longName.value_or(GetUstarName(header)),
+				.type = header.typeflag == '\0' ? '0' : header.typeflag,
+				.mode = static_cast<mode_t>(ParseNumber(header.mode, sizeof(header.mode))),
+				.mtime = static_cast<time_t>(ParseNumber(header.mtime, sizeof(header.mtime))),
+				.size = paxSize.value_or(size),
+				.dataOffset = m_offset,
+				.codec = codec,
+			};
+			m_remaining = (member.size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+
+			return member;
+		}
+	}
+
+	std::vector<char> ReadData(TarMember const& member)
+	{
+		if (member.dataOffset != m_offset || m_remaining < member.size)
+		{
+			throw std::logic_error("Tar member data has already been consumed");
+		}
+		std::vector<char> data(member.size);
+		ReadExactOrThrow(data.data(), data.size());
+		m_remaining -= member.size;
+
+		return data;
+	}
+
+private:
+	static bool IsZeroBlock(TarHeader const& header)
+	{
+		const auto bytes = std::span(reinterpret_cast<const char*>(&header), sizeof(header));
+		return std::ranges::all_of(bytes, [](const char c) { return c == 0; });
+	}
+
+	static void VerifyChecksum(TarHeader const& header)
+	{
+		auto copy = header;
+		std::memset(copy.chksum, ' ', sizeof(copy.chksum));
+		uint64_t checksum = 0;
+		for (const auto c : std::span(reinterpret_cast<const unsigned char*>(&copy), sizeof(copy)))
+		{
+			checksum += c;
+		}
+		if (checksum != ParseNumber(header.chksum, sizeof(header.chksum)))
+		{
+			throw std::runtime_error("Invalid tar header checksum");
+		}
+	}
+
+	static uint64_t ParseNumber(const char* field, const size_t fieldSize)
+	{
+		uint64_t value = 0;
+		if (static_cast<unsigned char>(field[0]) & 0x80)
+		{
+			// GNU base-256
+			value = static_cast<unsigned char>(field[0]) & 0x7f;
+			for (size_t i = 1; i < fieldSize; ++i)
+			{
+				value = (value << 8) | static_cast<unsigned char>(field[i]);
+			}
+			return value;
+		}
+
+		size_t i = 0;
+		while (i < fieldSize && field[i] == ' ')
+		{
+			++i;
+		}
+		for (; i < fieldSize && field[i] >= '0' && field[i] <= '7'; ++i)
+		{
+			value = (value << 3) | static_cast<uint64_t>(field[i] - '0');
+		}
+		return value;
+	}
+
+	static std::string GetField(const char* field, const size_t fieldSize)
+	{
+		return { field, strnlen(field, fieldSize) };
+	}
+
+	static std::string GetUstarName(TarHeader const& header)
+	{
+		auto name = GetField(header.name, sizeof(header.name));
+		if (std::memcmp(header.magic, "ustar", 5) == 0 && header.prefix[0] != '\0')
+		{
+			name = GetField(header.prefix, sizeof(header.prefix)) + "/" + name;
+		}
+		return name;
+	}
+
+	static void ParsePaxRecords(std::string const& data, std::optional<std::string>& path, std::optional<uint64_t>& size,
+		std::optional<std::string>& codec)
+	{
+		size_t pos = 0;
+		while (pos < data.size())
+		{
+			const auto space = data.find(' ', pos);
+			if (space == std::string::npos)
+			{
+				break;
+			}
+			const auto length = std::stoull(data.substr(pos, space - pos));
+			if (length == 0 || pos + length > data.size())
+			{
+				throw std::runtime_error("Invalid pax header");
+			}
+			const auto record = data.substr(space + 1, pos + length - space - 2);
+			const auto eq = record.find('=');
+			if (eq != std::string::npos)
+			{
+				const auto key = record.substr(0, eq);
+				const auto value = record.substr(eq + 1);
+				if (key == "path")
+				{
+					path = value;
+				}
+				else if (key == "size")
+				{
+					size = std::stoull(value);
+				}
+				else if (key == CODEC_PAX_KEY || key == LEGACY_CODEC_PAX_KEY)
+				{
+					codec = value;
+				}
+			}
+			pos += length;
+		}
+	}
+
+	size_t ReadSome(void* buffer, const size_t length)
+	{
+		if (m_bufferPos == m_bufferEnd)
+		{
+			if (length >= m_buffer.size())
+			{
+				// большие куски читаем сразу в буфер получателя
+				const auto bytesRead = m_input.Read(buffer, length);
+				m_offset += bytesRead;
+				return bytesRead;
+			}
+			m_bufferPos = 0;
+			m_bufferEnd = m_input.Read(m_buffer.data(), m_buffer.size());
+			if (m_bufferEnd == 0)
+			{
+				return 0;
+			}
+		}
+		const auto n = std::min(length, m_bufferEnd - m_bufferPos);
+		std::memcpy(buffer, m_buffer.data() + m_bufferPos, n);
+		m_bufferPos += n;
+		m_offset += n;
+		return n;
+	}
+
+	bool ReadExact(void* buffer, const size_t length)
+	{
+		size_t done = 0;
+		while (done < length)
+		{
+			const auto bytesRead = ReadSome(static_cast<char*>(buffer) + done, length - done);
+			if (bytesRead == 0)
+			{
+				if (done == 0)
+				{
+					return false;
+				}
+				throw std::runtime_error("Unexpected end of tar archive");
+			}
+			done += bytesRead;
+		}
+		return true;
+	}
+
+	void ReadExactOrThrow(void* buffer, const size_t length)
+	{
+		if (length != 0 && !ReadExact(buffer, length))
+		{
+			throw std::runtime_error("Unexpected end of tar archive");
+		}
+	}
+
+	void Skip(uint64_t length)
+	{
+		const auto buffered = std::min<uint64_t>(length, m_bufferEnd - m_bufferPos);
+		m_bufferPos += buffered;
+		m_offset += buffered;
+		length -= buffered;
+		if (length == 0)
+		{
+			return;
+		}
+
+		if (m_seekable)
+		{
+			// lseek за конец файла не ошибка, без проверки обрезанный архив закончился бы молча
+			struct stat st{};
+			if (fstat(m_input.Get(), &st) != 0)
+			{
+				throw std::system_error(errno, std::generic_category(), "Error reading tar archive size");
+			}
+			if (S_ISREG(st.st_mode) && m_offset + length > static_cast<uint64_t>(st.st_size))
+			{
+				throw std::runtime_error("Unexpected end of tar archive");
+			}
+			if (lseek(m_input.Get(), static_cast<off_t>(m_offset + length), SEEK_SET) == -1)
+			{
+				throw std::system_error(errno, std::generic_category(), "Error seeking tar archive");
+			}
+			m_offset += length;
+			return;
+		}
+
+		std::vector<char> sink(std::min<uint64_t>(length, m_buffer.size()));
+		while (length != 0)
+		{
+			const auto n = std::min<uint64_t>(length, sink.size());
+			ReadExactOrThrow(sink.data(), n);
+			length -= n;
+		}
+	}
+
+	FileDesc& m_input;
+	bool m_seekable;
+	uint64_t m_offset;
+	uint64_t m_remaining = 0;
+	std::vector<char> m_buffer = std::vector<char>(1 << 20);
+	size_t m_bufferPos = 0;
+	size_t m_bufferEnd = 0;
+};
@@ -0,0 +1,354 @@
+#pragma once
+#include "../lib/osWrappers/FileDesc.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <string>
+#include <sys/uio.h>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+constexpr size_t TAR_BLOCK_SIZE = 512;
+
+struct TarHeader
+{
+	char name[100];
+	char mode[8];
+	char uid[8];
+	char gid[8];
+	char size[12];
+	char mtime[12];
+	char chksum[8];
+	char typeflag;
+	char linkname[100];
+	char magic[6];
+	char version[2];
+	char uname[32];
+	char gname[32];
+	char devmajor[8];
+	char devminor[8];
+	char prefix[155];
+	char pad[12];
+};
+static_assert(sizeof(TarHeader) == TAR_BLOCK_SIZE);
+
+struct TarMemberInfo
+{
+	std::string name;
+	mode_t mode = 0644;
+	time_t mtime = 0;
+	// дополнительные записи pax-заголовка, ключи с префиксом производителя (CODEC_PAX_KEY)
+	std::vector<std::pair<std::string, std::string>> paxRecords{};
+};
+
+// Codec члена, если он не следует из имени. Ключ оформлен как пользовательский xattr в пространстве SCHILY:
+// GNU tar и bsdtar принимают его молча (с --xattrs восстанавливают как user.archive.codec)
+inline const std::string CODEC_PAX_KEY = "SCHILY.xattr.user.archive.codec";
+// ключ из первых версий архиватора, его GNU tar считает неизвестным и предупреждает
+inline const std::string LEGACY_CODEC_PAX_KEY = "PC.codec";
+
+// Куда TarWriter отправляет байты архива. Write дописывает в конец, WriteAt переписывает уже записанный заголовок
+class ArchiveOutput
+{
+public:
+	virtual ~ArchiveOutput() = default;
+	virtual void Write(std::span<const iovec> parts) = 0;
+	virtual void WriteAt(uint64_t offset, std::span<const char> data) = 0;
+};
+
+class FileArchiveOutput final : public ArchiveOutput
+{
+public:
+	explicit FileArchiveOutput(FileDesc& output)
+		: m_output(output)
+	{
+	}
+
+	void Write(std::span<const iovec> parts) override
+	{
+		std::array<iovec, 4> vec{};
+		size_t count = 0;
+		for (const auto& part : parts)
+		{
+			if (part.iov_len != 0)
+			{
+				vec.at(count++) = part;
+			}
+		}
+
+		auto* current = vec.data();
+		while (count != 0)
+		{
+			const auto written = writev(m_output.Get(), current, static_cast<int>(count));
+			if (written == -1)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				throw std::system_error(errno, std::generic_category(), "Error writing tar archive");
+			}
+
+			auto rest = static_cast<size_t>(written);
+			while (count != 0 && rest >= current->iov_len)
+			{
+				rest -= current->iov_len;
+				++current;
+				--count;
+			}
+			if (count != 0)
+			{
+				current->iov_base = static_cast<char*>(current->iov_base) + rest;
+				current->iov_len -= rest;
+			}
+		}
+	}
+
+	void WriteAt(uint64_t offset, std::span<const char> data) override
+	{
+		while (!data.empty())
+		{
+			const auto written = pwrite(m_output.Get(), data.data(), data.size(), static_cast<off_t>(offset));
+			if (written == -1)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				throw std::system_error(errno, std::generic_category(), "Error writing tar archive");
+			}
+			offset += static_cast<uint64_t>(written);
+			data = data.subspan(static_cast<size_t>(written));
+		}
+	}
+
+private:
+	FileDesc& m_output;
+};
+
+// Пишет ustar-архив прямо в дескриптор: pax-заголовок для длинных имён и доп. атрибутов, base-256 для файлов больше 8 ГБ
+class TarWriter
+{
+public:
+	explicit TarWriter(FileDesc& output)
+		: m_fileOutput(output)
+		  , m_output(*m_fileOutput)
+	{
+	}
+
+	explicit TarWriter(ArchiveOutput& output)
+		: m_output(output)
+	{
+	}
+
+	TarWriter(const TarWriter&) = delete;
+	TarWriter& operator=(const TarWriter&) = delete;
+
+	// Возвращает смещение данных члена в архиве
+	uint64_t AddFile(TarMemberInfo const& info, std::span<const char> data)
+	{
+		auto header = MakeHeader(info);
+		FillHeader(header, data.size());
+		const auto dataOffset = m_offset + sizeof(header);
+		WriteMember(header, data);
+		return dataOffset;
+	}
+
+	// Потоковая запись члена, размер которого заранее неизвестен: заголовок дописывается в EndFile через pwrite
+	uint64_t BeginFile(TarMemberInfo const& info)
+	{
+		m_pendingHeader = MakeHeader(info);
+		m_pendingHeaderOffset = m_offset;
+		m_pendingSize = 0;
+		WriteAll({ iovec{ &m_pendingHeader, sizeof(m_pendingHeader) } });
+		return m_offset;
+	}
+
+	void AppendData(std::span<const char> data)
+	{
+		WriteAll({ iovec{ const_cast<char*>(data.data()), data.size() } });
+		m_pendingSize += data.size();
+	}
+
+	void EndFile()
+	{
+		static const std::array<char, TAR_BLOCK_SIZE> padding{};
+		const auto paddingSize = (TAR_BLOCK_SIZE - m_pendingSize % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+		WriteAll({ iovec{ const_cast<char*>(padding.data()), paddingSize } });
+
+		FillHeader(m_pendingHeader, m_pendingSize);
+		m_output.WriteAt(m_pendingHeaderOffset, { reinterpret_cast<const char*>(&m_pendingHeader), sizeof(m_pendingHeader) });
+	}
+
+	void Finish()
+	{
+		const std::array<char, TAR_BLOCK_SIZE * 2> endBlocks{};
+		WriteAll({ iovec{ const_cast<char*>(endBlocks.data()), endBlocks.size() } });
+	}
+
+	[[nodiscard]] uint64_t GetOffset() const
+	{
+		return m_offset;
+	}
+
+private:
+	static constexpr uint64_t MAX_OCTAL_SIZE = 077777777777ull + 1;
+
+	static bool SplitName(std::string const& name, TarHeader& header)
+	{
+		if (name.size() <= sizeof(header.name))
+		{
+			std::memcpy(header.name, name.data(), name.size());
+			return true;
+		}
+
+		for (auto slash = name.rfind('/'); slash != std::string::npos && slash != 0; slash = name.rfind('/', slash - 1))
+		{
+			const auto rest = name.size() - slash - 1;
+			if (rest > sizeof(header.name))
+			{
+				return false;
+			}
+			if (slash <= sizeof(header.prefix))
+			{
+				std::memcpy(header.prefix, name.data(), slash);
+				std::memcpy(header.name, name.data() + slash + 1, rest);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	static void WriteOctal(char* field, const size_t fieldSize, uint64_t value)
+	{
+		std::memset(field, '0', fieldSize - 1);
+		field[fieldSize - 1] = '\0';
+		for (auto i = fieldSize - 1; i > 0 && value != 0; --i, value >>= 3)
+		{
+			field[i - 1] = static_cast<char>('0' + (value & 7));
+		}
+	}
+
+	TarHeader MakeHeader(TarMemberInfo const& info)
+	{
+		auto name = info.name;
+		name.erase(0, name.find_first_not_of('/'));
+		TarHeader header{};
+		const bool fitsUstar = SplitName(name, header);
+		if (!fitsUstar || !info.paxRecords.empty())
+		{
+			auto records = info.paxRecords;
+			if (!fitsUstar)
+			{
+				records.emplace_back("path", name);
+				std::memset(&header, 0, sizeof(header));
+				// имя обрезается, полное - в записи path; завершающий ноль в поле name не обязателен
+				std::memcpy(header.name, name.data(), std::min(name.size(), sizeof(header.name)));
+			}
+			WritePaxHeader(records);
+		}
+
+		WriteOctal(header.mode, sizeof(header.mode), info.mode & 07777);
+		WriteOctal(header.uid, sizeof(header.uid), 0);
+		WriteOctal(header.gid, sizeof(header.gid), 0);
+		WriteOctal(header.mtime, sizeof(header.mtime), static_cast<uint64_t>(std::max<time_t>(info.mtime, 0)));
+		header.typeflag = '0';
+		std::memcpy(header.magic, "ustar", 6);
+		std::memcpy(header.version, "00", 2);
+
+		return header;
+	}
+
+	static void FillHeader(TarHeader& header, const uint64_t size)
+	{
+		if (size < MAX_OCTAL_SIZE)
+		{
+			WriteOctal(header.size, sizeof(header.size), size);
+		}
+		else
+		{
+			// GNU base-256: старший бит первого байта и размер в big-endian
+			std::memset(header.size, 0, sizeof(header.size));
+			header.size[0] = static_cast<char>(0x80);
+			for (auto i = sizeof(header.size) - 1, value = size; i > 0; --i, value >>= 8)
+			{
+				header.size[i] = static_cast<char>(value & 0xff);
+			}
+		}
+
+		std::memset(header.chksum, ' ', sizeof(header.chksum));
+		unsigned checksum = 0;
+		for (const auto c : std::span(reinterpret_cast<const unsigned char*>(&header), sizeof(header)))
+		{
+			checksum += c;
+		}
+		WriteOctal(header.chksum, sizeof(header.chksum) - 1, checksum);
+	}
+
+	static std::string PaxRecord(std::string const& key, std::string const& value)
+	{
+		// длина записи включает саму себя, поэтому подбираем её итеративно
+		const auto payload = " " + key + "=" + value + "\n";
+		auto length = payload.size();
+		while (std::to_string(length).size() + payload.size() != length)
+		{
+			length = std::to_string(length).size() + payload.size();
+		}
+		return std::to_string(length) + payload;
+	}
+
+	void WritePaxHeader(std::vector<std::pair<std::string, std::string>> const& paxRecords)
+	{
+		std::string records;
+		for (const auto& [key, value] : paxRecords)
+		{
+			records += PaxRecord(key, value);
+		}
+		TarHeader header{};
+		std::strncpy(header.name, "././@PaxHeader", sizeof(header.name));
+		WriteOctal(header.mode, sizeof(header.mode), 0644);
+		WriteOctal(header.uid, sizeof(header.uid), 0);
+		WriteOctal(header.gid, sizeof(header.gid), 0);
+		WriteOctal(header.mtime, sizeof(header.mtime), 0);
+		header.typeflag = 'x';
+		std::memcpy(header.magic, "ustar", 6);
+		std::memcpy(header.version, "00", 2);
+		FillHeader(header, records.size());
+		WriteMember(header, records);
+	}
+
+	void WriteMember(TarHeader const& header, std::span<const char> data)
+	{
+		static const std::array<char, TAR_BLOCK_SIZE> padding{};
+		const auto paddingSize = (TAR_BLOCK_SIZE - data.size() % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+		WriteAll({
+			iovec{ const_cast<TarHeader*>(&header), sizeof(header) },
+			iovec{ const_cast<char*>(data.data()), data.size() },
+			iovec{ const_cast<char*>(padding.data()), paddingSize },
+		});
+	}
+
+	void WriteAll(std::initializer_list<iovec> parts)
+	{
+		m_output.Write({ parts.begin(), parts.size() });
+		for (const auto& part : parts)
+		{
+			m_offset += part.iov_len;
+		}
+	}
+
+	std::optional<FileArchiveOutput> m_fileOutput;
+	ArchiveOutput& m_output;
+	uint64_t m_offset = 0;
+	TarHeader m_pendingHeader{};
+	uint64_t m_pendingHeaderOffset = 0;
+	uint64_t m_pendingSize = 0;
+};
@@ -10,8 +10,8 @@ class Timer
 
 public:
 	explicit Timer(std::ostream& output, std::string name)
-		: m_name(name)
-		  , m_output(output)
+		: m_output(output)
+		  , m_name(name)
 	{
 	}
 
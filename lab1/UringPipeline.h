@@ -0,0 +1,494 @@
+#pragma once
+#include "ArchiveWriter.h"
+#include "FileContent.h"
+#include "IoUring.h"
+#include "ParallelCompression.h"
+#include "TarWriter.h"
+#include "WorkerPool.h"
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// Входные данные заданий сжатия читаются пачками через io_uring в зарегистрированные буферы, сжимает их WorkerPool.
+// Чтения ставит поток, вызывающий SubmitCompression, завершения разбирает отдельный поток.
+// Если этот поток упал, его ошибка приходит в ожидающие future и повторно выбрасывается в Submit
+class UringCompressionPool
+{
+public:
+	// целый файл - не больше двух блоков, блок - со словарём перед ним
+	static constexpr size_t BUFFER_SIZE = 2 * COMPRESSION_BLOCK_SIZE;
+	static constexpr unsigned READ_BATCH = 8;
+
+	UringCompressionPool(WorkerPool& pool, const unsigned buffersNum)
+		: m_pool(pool)
+		  , m_ring(2 * std::max(buffersNum, 1u) + 1)
+		  , m_buffers(std::max(buffersNum, 1u))
+	{
+		std::vector<iovec> registered;
+		for (size_t i = 0; i < m_buffers.size(); ++i)
+		{
+			m_buffers[i].resize(BUFFER_SIZE);
+			registered.push_back({ m_buffers[i].data(), m_buffers[i].size() });
+			m_freeBuffers.push_back(i);
+		}
+		m_ring.RegisterBuffers(registered);
+		m_reaper = std::jthread([this] {
+			ReapCompletions();
+		});
+	}
+
+	UringCompressionPool(const UringCompressionPool&) = delete;
+	UringCompressionPool& operator=(const UringCompressionPool&) = delete;
+
+	~UringCompressionPool()
+	{
+		try
+		{
+			// буферы заняты, пока их читают или сжимают, и освобождаются в любом случае,
+			// кроме чтений, брошенных упавшим потоком завершений
+			Flush();
+			std::unique_lock lock(m_mutex);
+			m_bufferFreed.wait(lock, [this] { return m_freeBuffers.size() + m_lostBuffers == m_buffers.size(); });
+			if (m_reaperError)
+			{
+				return;
+			}
+			lock.unlock();
+
+			auto& sqe = m_ring.GetSqe();
+			io_uring_prep_nop(&sqe);
+			io_uring_sqe_set_data64(&sqe, STOP_USER_DATA);
+			m_ring.Submit();
+		}
+		catch (...)
+		{
+			std::terminate();
+		}
+	}
+
+	[[nodiscard]] unsigned GetBuffersNum() const
+	{
+		return static_cast<unsigned>(m_buffers.size());
+	}
+
+	std::future<CompressedBlock> Submit(CompressionTask task)
+	{
+		RethrowReaperError();
+		const auto readStart = task.wholeFile ? 0 : GetDictionaryStart(task.blockStart);
+		const auto readSize = task.blockEnd - readStart;
+		if (readSize > BUFFER_SIZE)
+		{
+			throw std::logic_error("Compression task does not fit into io_uring buffer");
+		}
+
+		auto request = std::make_unique<ReadRequest>();
+		request->file = GetFile(task.file);
+		request->buffer = AcquireBuffer();
+		request->offset = readStart;
+		request->size = readSize;
+		request->task = std::move(task);
+		auto result = request->promise.get_future();
+
+		auto& sqe = m_ring.GetSqe();
+		io_uring_prep_read_fixed(&sqe, request->file->Get(), m_buffers[request->buffer].data(), static_cast<unsigned>(readSize), readStart,
+			static_cast<int>(request->buffer));
+		{
+			std::lock_guard lock(m_mutex);
+			m_reads.insert(request.get());
+		}
+		io_uring_sqe_set_data64(&sqe, reinterpret_cast<uint64_t>(request.release()));
+		if (++m_queued >= READ_BATCH)
+		{
+			Flush();
+		}
+
+		// ожидающий результата сначала отправляет накопленную пачку, иначе её чтения никогда не начнутся
+		return std::async(std::launch::deferred, [this, result = std::move(result)]() mutable {
+			Flush();
+			return result.get();
+		});
+	}
+
+private:
+	static constexpr uint64_t STOP_USER_DATA = 0;
+
+	struct ReadRequest
+	{
+		CompressionTask task;
+		std::shared_ptr<FileDesc> file;
+		size_t buffer;
+		uint64_t offset;
+		size_t size;
+		std::promise<CompressedBlock> promise;
+	};
+
+	void RethrowReaperError()
+	{
+		std::lock_guard lock(m_mutex);
+		if (m_reaperError)
+		{
+			std::rethrow_exception(m_reaperError);
+		}
+	}
+
+	void Flush()
+	{
+		if (m_queued != 0)
+		{
+			m_ring.Submit();
+			m_queued = 0;
+		}
+	}
+
+	// Соседние блоки большого файла читаются через один дескриптор
+	std::shared_ptr<FileDesc> GetFile(std::string const& file)
+	{
+		if (!m_lastFile || m_lastFileName != file)
+		{
+			m_lastFile = std::make_shared<FileDesc>(OpenFile(file, O_RDONLY));
+			m_lastFileName = file;
+		}
+		return m_lastFile;
+	}
+
+	size_t AcquireBuffer()
+	{
+		std::unique_lock lock(m_mutex);
+		if (m_freeBuffers.empty())
+		{
+			lock.unlock();
+			Flush();
+			lock.lock();
+			m_bufferFreed.wait(lock, [this] { return !m_freeBuffers.empty() || m_reaperError; });
+		}
+		if (m_reaperError)
+		{
+			std::rethrow_exception(m_reaperError);
+		}
+		const auto buffer = m_freeBuffers.back();
+		m_freeBuffers.pop_back();
+		return buffer;
+	}
+
+	void ReleaseBuffer(const size_t buffer)
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_freeBuffers.push_back(buffer);
+		}
+		m_bufferFreed.notify_all();
+	}
+
+	void ReapCompletions()
+	{
+		try
+		{
+			ReapCompletionsUntilStop();
+		}
+		catch (...)
+		{
+			// незавершённые чтения уже не разобрать: их future получают ту же ошибку, а буферы не возвращаются
+			std::lock_guard lock(m_mutex);
+			m_reaperError = std::current_exception();
+			for (auto* request : m_reads)
+			{
+				request->promise.set_exception(m_reaperError);
+				delete request;
+			}
+			m_lostBuffers = m_reads.size();
+			m_reads.clear();
+			m_bufferFreed.notify_all();
+		}
+	}
+
+	void ReapCompletionsUntilStop()
+	{
+		while (true)
+		{
+			const auto completion = m_ring.WaitCompletion();
+			if (completion.userData == STOP_USER_DATA)
+			{
+				return;
+			}
+
+			std::shared_ptr<ReadRequest> request(reinterpret_cast<ReadRequest*>(completion.userData));
+			{
+				std::lock_guard lock(m_mutex);
+				m_reads.erase(request.get());
+			}
+			try
+			{
+				if (completion.result < 0)
+				{
+					throw std::system_error(-completion.result, std::generic_category(), "Error reading " + request->task.file);
+				}
+				const auto content = ReadRest(*request, static_cast<size_t>(completion.result));
+				m_pool.Submit([this, request, content] {
+					try
+					{
+						request->promise.set_value(CompressBuffer(request->task, content));
+					}
+					catch (...)
+					{
+						request->promise.set_exception(std::current_exception());
+					}
+					ReleaseBuffer(request->buffer);
+				});
+			}
+			catch (...)
+			{
+				request->promise.set_exception(std::current_exception());
+				ReleaseBuffer(request->buffer);
+			}
+		}
+	}
+
+	// Короткое чтение обычного файла - редкость, остаток дочитывается синхронно.
+	// Файл короче, чем при постановке задания, - ошибка и для блока, и для целого файла
+	std::span<const char> ReadRest(ReadRequest const& request, size_t done)
+	{
+		auto* buffer = m_buffers[request.buffer].data();
+		while (done < request.size)
+		{
+			const auto bytesRead = pread(request.file->Get(), buffer + done, request.size - done, static_cast<off_t>(request.offset + done));
+			if (bytesRead == -1 && errno == EINTR)
+			{
+				continue;
+			}
+			if (bytesRead == -1)
+			{
+				throw std::system_error(errno, std::generic_category(), "Error reading " + request.task.file);
+			}
+			if (bytesRead == 0)
+			{
+				break;
+			}
+			done += static_cast<size_t>(bytesRead);
+		}
+		if (done != request.size)
+		{
+			throw std::runtime_error("File changed while archiving: " + request.task.file);
+		}
+		return { buffer, done };
+	}
+
+	static CompressedBlock CompressBuffer(CompressionTask const& task, std::span<const char> content)
+	{
+		try
+		{
+			if (task.wholeFile)
+			{
+				return CompressContent(content, CodecSelector(task.codec));
+			}
+			return CompressBlockContent(GetCodec(task.codec.value()), content, task.blockStart - GetDictionaryStart(task.blockStart), task.last);
+		}
+		catch (const std::exception& e)
+		{
+			throw std::runtime_error("Error compressing " + task.file + ": " + e.what());
+		}
+	}
+
+	WorkerPool& m_pool;
+	IoUring m_ring;
+	std::vector<std::vector<char>> m_buffers;
+	std::mutex m_mutex;
+	std::condition_variable m_bufferFreed;
+	std::vector<size_t> m_freeBuffers;
+	// чтения, отправленные в кольцо и ещё не разобранные
+	std::unordered_set<ReadRequest*> m_reads;
+	std::exception_ptr m_reaperError;
+	size_t m_lostBuffers = 0;
+	unsigned m_queued = 0;
+	std::shared_ptr<FileDesc> m_lastFile;
+	std::string m_lastFileName;
+	// объявлен последним: останавливается раньше, чем разрушаются кольцо и буферы
+	std::jthread m_reaper;
+};
+
+inline std::future<CompressedBlock> SubmitCompression(UringCompressionPool& pool, CompressionTask task)
+{
+	return pool.Submit(std::move(task));
+}
+
+// Архив собирается в зарегистрированных буферах и пишется write_fixed по явным смещениям,
+// не дожидаясь окончания предыдущих записей. Заголовок потокового члена, ушедший на диск, переписывается
+// с IOSQE_IO_DRAIN: ядро начнёт эту запись только после всех ранее поставленных
+class UringArchiveOutput final : public ArchiveOutput
+{
+public:
+	static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+	explicit UringArchiveOutput(FileDesc& output, const unsigned buffersNum = 8)
+		: m_output(output)
+		  , m_ring(std::max(buffersNum, 1u) + 1)
+		  , m_buffers(std::max(buffersNum, 1u))
+	{
+		std::vector<iovec> registered;
+		for (size_t i = 0; i < m_buffers.size(); ++i)
+		{
+			m_buffers[i].resize(BUFFER_SIZE);
+			registered.push_back({ m_buffers[i].data(), m_buffers[i].size() });
+			m_freeBuffers.push_back(i);
+		}
+		m_ring.RegisterBuffers(registered);
+		m_current = AcquireBuffer();
+	}
+
+	~UringArchiveOutput() override
+	{
+		try
+		{
+			WaitAll();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void Write(std::span<const iovec> parts) override
+	{
+		for (const auto& part : parts)
+		{
+			std::span data(static_cast<const char*>(part.iov_base), part.iov_len);
+			while (!data.empty())
+			{
+				const auto n = std::min(data.size(), BUFFER_SIZE - m_used);
+				std::memcpy(m_buffers[m_current].data() + m_used, data.data(), n);
+				m_used += n;
+				data = data.subspan(n);
+				if (m_used == BUFFER_SIZE)
+				{
+					FlushCurrent();
+				}
+			}
+		}
+	}
+
+	void WriteAt(const uint64_t offset, std::span<const char> data) override
+	{
+		if (offset >= m_currentOffset && offset + data.size() <= m_currentOffset + m_used)
+		{
+			std::memcpy(m_buffers[m_current].data() + (offset - m_currentOffset), data.data(), data.size());
+			return;
+		}
+
+		FlushCurrent();
+		auto& patch = m_patches.emplace_back(data.begin(), data.end());
+		auto& sqe = m_ring.GetSqe();
+		io_uring_prep_write(&sqe, m_output.Get(), patch.data(), static_cast<unsigned>(patch.size()), offset);
+		io_uring_sqe_set_flags(&sqe, IOSQE_IO_DRAIN);
+		io_uring_sqe_set_data64(&sqe, PATCH_USER_DATA | patch.size());
+		m_ring.Submit();
+		++m_inFlight;
+	}
+
+	// Дописывает остаток и ждёт все записи; ошибки записи всплывают здесь
+	void Close()
+	{
+		FlushCurrent();
+		WaitAll();
+	}
+
+private:
+	// в userData записи буфера - его номер, у записи заголовка - флаг и длина
+	static constexpr uint64_t PATCH_USER_DATA = uint64_t{ 1 } << 63;
+
+	void FlushCurrent()
+	{
+		if (m_used == 0)
+		{
+			return;
+		}
+		auto& sqe = m_ring.GetSqe();
+		io_uring_prep_write_fixed(&sqe, m_output.Get(), m_buffers[m_current].data(), static_cast<unsigned>(m_used), m_currentOffset,
+			static_cast<int>(m_current));
+		io_uring_sqe_set_data64(&sqe, m_current);
+		m_ring.Submit();
+		++m_inFlight;
+		m_expectedSizes[m_current] = m_used;
+
+		m_currentOffset += m_used;
+		m_used = 0;
+		m_current = AcquireBuffer();
+	}
+
+	size_t AcquireBuffer()
+	{
+		while (m_freeBuffers.empty())
+		{
+			HandleCompletion(m_ring.WaitCompletion());
+		}
+		const auto buffer = m_freeBuffers.back();
+		m_freeBuffers.pop_back();
+		return buffer;
+	}
+
+	void WaitAll()
+	{
+		while (m_inFlight != 0)
+		{
+			HandleCompletion(m_ring.WaitCompletion());
+		}
+		m_patches.clear();
+	}
+
+	void HandleCompletion(IoUring::Completion const& completion)
+	{
+		--m_inFlight;
+		const bool isPatch = (completion.userData & PATCH_USER_DATA) != 0;
+		const auto expected = isPatch ? completion.userData & ~PATCH_USER_DATA : m_expectedSizes[completion.userData];
+		if (!isPatch)
+		{
+			m_freeBuffers.push_back(completion.userData);
+		}
+		if (completion.result < 0)
+		{
+			throw std::system_error(-completion.result, std::generic_category(), "Error writing tar archive");
+		}
+		if (static_cast<size_t>(completion.result) != expected)
+		{
+			throw std::runtime_error("Short write to tar archive");
+		}
+	}
+
+	FileDesc& m_output;
+	IoUring m_ring;
+	std::vector<std::vector<char>> m_buffers;
+	std::map<size_t, size_t> m_expectedSizes;
+	std::vector<size_t> m_freeBuffers;
+	// копии переписываемых заголовков живут до завершения всех записей
+	std::deque<std::vector<char>> m_patches;
+	size_t m_current = 0;
+	size_t m_used = 0;
+	uint64_t m_currentOffset = 0;
+	unsigned m_inFlight = 0;
+};
+
+// Чтение входных файлов, сжатие и запись архива идут одновременно: пока потоки сжимают,
+// в io_uring стоят следующие чтения и предыдущие записи
+inline std::vector<std::chrono::milliseconds> WriteArchiveWithUring(std::string const& archivePath, std::vector<std::string> const& files,
+	const unsigned threadsNum, CodecSelector const& selector)
+{
+	WorkerPool pool(threadsNum);
+	auto output = OpenFile(archivePath, O_WRONLY | O_CREAT | O_TRUNC);
+	{
+		UringArchiveOutput archiveOutput(output);
+		UringCompressionPool uringPool(pool, pool.GetThreadsNum() * 2 + UringCompressionPool::READ_BATCH);
+		TarWriter writer(archiveOutput);
+		ArchiveSink sink(writer);
+		CompressFilesOrdered(files, selector, uringPool, uringPool.GetBuffersNum(), sink);
+		sink.WriteIndex();
+		writer.Finish();
+		archiveOutput.Close();
+	}
+	output.Close();
+
+	return pool.GetBusyTimes();
+}
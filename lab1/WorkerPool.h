@@ -0,0 +1,122 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class WorkerPool
+{
+public:
+	explicit WorkerPool(const unsigned threadsNum)
+		: m_busyTimes(std::max(threadsNum, 1u))
+	{
+		m_workers.reserve(m_busyTimes.size());
+		for (size_t i = 0; i < m_busyTimes.size(); ++i)
+		{
+			m_workers.emplace_back([this, i](const std::stop_token& stopToken) {
+				WorkerThread(stopToken, m_busyTimes[i]);
+			});
+		}
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			for (auto& worker : m_workers)
+			{
+				worker.request_stop();
+			}
+		}
+		m_condVar.notify_all();
+	}
+
+	[[nodiscard]] unsigned GetThreadsNum() const
+	{
+		return static_cast<unsigned>(m_workers.size());
+	}
+
+	// Суммарное время выполнения задач каждым потоком, для оценки дисбаланса нагрузки
+	[[nodiscard]] std::vector<std::chrono::milliseconds> GetBusyTimes() const
+	{
+		std::vector<std::chrono::milliseconds> result;
+		result.reserve(m_busyTimes.size());
+		for (const auto& busyTime : m_busyTimes)
+		{
+			result.emplace_back(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::duration(busyTime.load())));
+		}
+		return result;
+	}
+
+	template <typename Fn>
+	auto Submit(Fn&& fn) -> std::future<std::invoke_result_t<Fn>>
+	{
+		using Result = std::invoke_result_t<Fn>;
+		// время учитывается до того, как future станет готов, иначе GetBusyTimes после get() может его не увидеть
+		auto task = std::make_shared<std::packaged_task<Result(BusyTime&)>>([fn = std::forward<Fn>(fn)](BusyTime& busyTime) mutable {
+			BusyScope scope{ busyTime };
+			return fn();
+		});
+		auto future = task->get_future();
+		{
+			std::lock_guard lock(m_mutex);
+			m_tasks.emplace([task](BusyTime& busyTime) { (*task)(busyTime); });
+		}
+		m_condVar.notify_one();
+
+		return future;
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+	using BusyTime = std::atomic<Clock::rep>;
+
+	struct BusyScope
+	{
+		BusyTime& busyTime;
+		Clock::time_point start = Clock::now();
+
+		~BusyScope()
+		{
+			busyTime += (Clock::now() - start).count();
+		}
+	};
+
+	void WorkerThread(const std::stop_token& stopToken, BusyTime& busyTime)
+	{
+		while (true)
+		{
+			std::function<void(BusyTime&)> task;
+			{
+				std::unique_lock lock(m_mutex);
+				m_condVar.wait(lock, [&] { return stopToken.stop_requested() || !m_tasks.empty(); });
+				if (m_tasks.empty())
+				{
+					return;
+				}
+				task = std::move(m_tasks.front());
+				m_tasks.pop();
+			}
+			// исключения задачи попадают в future через packaged_task
+			task(busyTime);
+		}
+	}
+
+	std::mutex m_mutex;
+	std::condition_variable m_condVar;
+	std::queue<std::function<void(BusyTime&)>> m_tasks;
+	std::vector<BusyTime> m_busyTimes;
+	std::vector<std::jthread> m_workers;
+};
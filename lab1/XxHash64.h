@@ -0,0 +1,125 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+// Потоковая реализация XXH64 (https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md).
+// Результат совпадает с XXH64() эталонной библиотеки при том же seed
+class XxHash64
+{
+public:
+	explicit XxHash64(const uint64_t seed = 0)
+		: m_seed(seed)
+		  , m_acc{ seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1 }
+	{
+	}
+
+	void Update(std::span<const char> data)
+	{
+		m_totalSize += data.size();
+		if (m_bufferSize != 0)
+		{
+			const auto n = std::min(data.size(), STRIPE_SIZE - m_bufferSize);
+			std::memcpy(m_buffer.data() + m_bufferSize, data.data(), n);
+			m_bufferSize += n;
+			data = data.subspan(n);
+			if (m_bufferSize < STRIPE_SIZE)
+			{
+				return;
+			}
+			ProcessStripe(m_buffer.data());
+			m_bufferSize = 0;
+		}
+		while (data.size() >= STRIPE_SIZE)
+		{
+			ProcessStripe(data.data());
+			data = data.subspan(STRIPE_SIZE);
+		}
+		std::memcpy(m_buffer.data(), data.data(), data.size());
+		m_bufferSize = data.size();
+	}
+
+	[[nodiscard]] uint64_t Digest() const
+	{
+		uint64_t hash;
+		if (m_totalSize >= STRIPE_SIZE)
+		{
+			hash = std::rotl(m_acc[0], 1) + std::rotl(m_acc[1], 7) + std::rotl(m_acc[2], 12) + std::rotl(m_acc[3], 18);
+			for (const auto acc : m_acc)
+			{
+				hash = (hash ^ Round(0, acc)) * PRIME1 + PRIME4;
+			}
+		}
+		else
+		{
+			hash = m_seed + PRIME5;
+		}
+		hash += m_totalSize;
+
+		const char* p = m_buffer.data();
+		auto remaining = m_bufferSize;
+		for (; remaining >= 8; p += 8, remaining -= 8)
+		{
+			hash = std::rotl(hash ^ Round(0, Read<uint64_t>(p)), 27) * PRIME1 + PRIME4;
+		}
+		if (remaining >= 4)
+		{
+			hash = std::rotl(hash ^ (Read<uint32_t>(p) * PRIME1), 23) * PRIME2 + PRIME3;
+			p += 4;
+			remaining -= 4;
+		}
+		for (; remaining > 0; ++p, --remaining)
+		{
+			hash = std::rotl(hash ^ (static_cast<unsigned char>(*p) * PRIME5), 11) * PRIME1;
+		}
+
+		hash ^= hash >> 33;
+		hash *= PRIME2;
+		hash ^= hash >> 29;
+		hash *= PRIME3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+private:
+	static constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+	static constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+	static constexpr uint64_t PRIME3 = 0x165667B19E3779F9ull;
+	static constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+	static constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+	static constexpr size_t STRIPE_SIZE = 32;
+
+	template <typename T>
+	static uint64_t Read(const char* p)
+	{
+		T value;
+		std::memcpy(&value, p, sizeof(value));
+		if constexpr (std::endian::native == std::endian::big)
+		{
+			value = std::byteswap(value);
+		}
+		return value;
+	}
+
+	static uint64_t Round(const uint64_t acc, const uint64_t lane)
+	{
+		return std::rotl(acc + lane * PRIME2, 31) * PRIME1;
+	}
+
+	void ProcessStripe(const char* p)
+	{
+		for (size_t i = 0; i < m_acc.size(); ++i)
+		{
+			m_acc[i] = Round(m_acc[i], Read<uint64_t>(p + 8 * i));
+		}
+	}
+
+	uint64_t m_seed;
+	std::array<uint64_t, 4> m_acc;
+	std::array<char, STRIPE_SIZE> m_buffer{};
+	size_t m_bufferSize = 0;
+	uint64_t m_totalSize = 0;
+};
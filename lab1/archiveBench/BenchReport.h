@@ -0,0 +1,137 @@
+#pragma once
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct BenchResult
+{
+	std::string codec;
+	std::string operation;
+	unsigned threads = 1;
+	std::vector<double> seconds{};
+	uint64_t rawSize = 0;
+	uint64_t archiveSize = 0;
+	// заполняются в ComputeSpeedup относительно наименьшего числа потоков того же codec и операции
+	double speedup = 1.0;
+	double efficiency = 1.0;
+
+	[[nodiscard]] double GetMin() const
+	{
+		return *std::ranges::min_element(seconds);
+	}
+
+	[[nodiscard]] double GetMedian() const
+	{
+		auto sorted = seconds;
+		std::ranges::sort(sorted);
+		const auto middle = sorted.size() / 2;
+		return sorted.size() % 2 != 0 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+	}
+
+	[[nodiscard]] double GetThroughput() const
+	{
+		return static_cast<double>(rawSize) / 1e6 / GetMedian();
+	}
+
+	[[nodiscard]] double GetRatio() const
+	{
+		return rawSize != 0 ? static_cast<double>(archiveSize) / static_cast<double>(rawSize) : 1.0;
+	}
+};
+
+inline void ComputeSpeedup(std::vector<BenchResult>& results)
+{
+	for (auto& result : results)
+	{
+		const BenchResult* base = nullptr;
+		for (const auto& other : results)
+		{
+			if (other.codec == result.codec && other.operation == result.operation && (!base || other.threads < base->threads))
+			{
+				base = &other;
+			}
+		}
+		result.speedup = base->GetMedian() / result.GetMedian();
+		result.efficiency = result.speedup * base->threads / result.threads;
+	}
+}
+
+inline void PrintResults(std::ostream& output, std::vector<BenchResult> const& results)
+{
+	const auto flags = output.flags();
+	const auto precision = output.precision();
+	output << std::left << std::setw(8) << "codec" << std::setw(9) << "op" << std::right
+		   << std::setw(8) << "threads" << std::setw(10) << "min s" << std::setw(10) << "median s"
+		   << std::setw(10) << "MB/s" << std::setw(9) << "speedup" << std::setw(8) << "eff" << std::setw(8) << "ratio" << std::endl;
+	output << std::fixed;
+	for (const auto& result : results)
+	{
+		output << std::left << std::setw(8) << result.codec << std::setw(9) << result.operation << std::right
+			   << std::setw(8) << result.threads
+			   << std::setprecision(3) << std::setw(10) << result.GetMin() << std::setw(10) << result.GetMedian()
+			   << std::setprecision(1) << std::setw(10) << result.GetThroughput()
+			   << std::setprecision(2) << std::setw(9) << result.speedup << std::setw(8) << result.efficiency
+			   << std::setprecision(3) << std::setw(8) << result.GetRatio() << std::endl;
+	}
+	output.flags(flags);
+	output.precision(precision);
+}
+
+inline std::ofstream OpenReport(std::string const& path)
+{
+	std::ofstream output(path);
+	if (!output)
+	{
+		throw std::runtime_error("Can not open report file " + path);
+	}
+	output << std::setprecision(6);
+	return output;
+}
+
+inline void WriteCsv(std::string const& path, std::vector<BenchResult> const& results)
+{
+	auto output = OpenReport(path);
+	output << "codec,operation,threads,repeats,min_s,median_s,mb_per_s,speedup,efficiency,raw_bytes,archive_bytes\n";
+	for (const auto& result : results)
+	{
+		output << result.codec << ',' << result.operation << ',' << result.threads << ',' << result.seconds.size() << ','
+			   << result.GetMin() << ',' << result.GetMedian() << ',' << result.GetThroughput() << ','
+			   << result.speedup << ',' << result.efficiency << ',' << result.rawSize << ',' << result.archiveSize << '\n';
+	}
+}
+
+struct BenchCorpusInfo
+{
+	uint64_t seed;
+	double scale;
+	size_t files;
+	uint64_t bytes;
+};
+
+// Имена codec и операций состоят из латиницы, поэтому строки пишутся без экранирования
+inline void WriteJson(std::string const& path, BenchCorpusInfo const& corpus, std::vector<BenchResult> const& results)
+{
+	auto output = OpenReport(path);
+	output << "{\n  \"corpus\": { \"seed\": " << corpus.seed << ", \"scale\": " << corpus.scale
+		   << ", \"files\": " << corpus.files << ", \"bytes\": " << corpus.bytes << " },\n  \"results\": [";
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const auto& result = results[i];
+		output << (i == 0 ? "\n" : ",\n")
+			   << "    { \"codec\": \"" << result.codec << "\", \"operation\": \"" << result.operation
+			   << "\", \"threads\": " << result.threads << ", \"seconds\": [";
+		for (size_t j = 0; j < result.seconds.size(); ++j)
+		{
+			output << (j == 0 ? "" : ", ") << result.seconds[j];
+		}
+		output << "], \"min_s\": " << result.GetMin() << ", \"median_s\": " << result.GetMedian()
+			   << ", \"mb_per_s\": " << result.GetThroughput() << ", \"speedup\": " << result.speedup
+			   << ", \"efficiency\": " << result.efficiency << ", \"raw_bytes\": " << result.rawSize
+			   << ", \"archive_bytes\": " << result.archiveSize << " }";
+	}
+	output << "\n  ]\n}\n";
+}
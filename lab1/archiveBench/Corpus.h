@@ -0,0 +1,137 @@
+#pragma once
+#include "../FileContent.h"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+// Содержимое файлов корпуса: текст сжимается в 3-4 раза, случайные данные не сжимаются,
+// смешанные чередуют фрагменты текста и шума
+enum class Entropy
+{
+	Text,
+	Random,
+	Mixed,
+};
+
+struct CorpusGroup
+{
+	std::string name;
+	size_t count;
+	size_t minSize;
+	size_t maxSize;
+	Entropy entropy;
+};
+
+struct Corpus
+{
+	std::vector<std::string> files;
+	uint64_t totalSize = 0;
+};
+
+// Мелкие файлы нагружают диспетчеризацию, крупные - поблочное сжатие и потоковую распаковку
+inline std::vector<CorpusGroup> GetDefaultCorpusGroups(const double scale)
+{
+	auto scaled = [scale](const size_t value) {
+		return std::max<size_t>(1, static_cast<size_t>(static_cast<double>(value) * scale));
+	};
+	return {
+		{ "small", scaled(256), 4 << 10, 64 << 10, Entropy::Text },
+		{ "medium", scaled(32), 256 << 10, 1 << 20, Entropy::Mixed },
+		{ "random", scaled(16), 1 << 20, 1 << 20, Entropy::Random },
+		{ "large", scaled(4), 24 << 20, 24 << 20, Entropy::Text },
+	};
+}
+
+// Используется только вывод mt19937_64, который задан стандартом, поэтому корпус
+// при одном seed одинаков на любой платформе (в отличие от std::*_distribution)
+class CorpusGenerator
+{
+public:
+	static constexpr size_t VOCABULARY_BITS = 12;
+	static constexpr size_t VOCABULARY_SIZE = size_t{ 1 } << VOCABULARY_BITS;
+	static constexpr size_t MIXED_SEGMENT_SIZE = 4096;
+
+	explicit CorpusGenerator(const uint64_t seed)
+		: m_random(seed)
+	{
+		m_vocabulary.reserve(VOCABULARY_SIZE);
+		for (size_t i = 0; i < VOCABULARY_SIZE; ++i)
+		{
+			std::string word(2 + Next(10), ' ');
+			for (auto& c : word)
+			{
+				c = static_cast<char>('a' + Next(26));
+			}
+			m_vocabulary.push_back(std::move(word));
+		}
+	}
+
+	Corpus Generate(std::filesystem::path const& folder, std::vector<CorpusGroup> const& groups)
+	{
+		Corpus corpus;
+		for (const auto& group : groups)
+		{
+			std::filesystem::create_directories(folder / group.name);
+			for (size_t i = 0; i < group.count; ++i)
+			{
+				const auto size = group.minSize + Next(group.maxSize - group.minSize + 1);
+				const auto path = (folder / group.name / (std::to_string(i) + ".dat")).string();
+				WriteFileContent(path, MakeContent(size, group.entropy));
+				corpus.files.push_back(path);
+				corpus.totalSize += size;
+			}
+		}
+		return corpus;
+	}
+
+private:
+	uint64_t Next(const uint64_t bound)
+	{
+		return m_random() % bound;
+	}
+
+	std::vector<char> MakeContent(const size_t size, const Entropy entropy)
+	{
+		std::vector<char> content;
+		content.reserve(size + MIXED_SEGMENT_SIZE);
+		bool text = entropy != Entropy::Random;
+		while (content.size() < size)
+		{
+			const auto segmentEnd = entropy == Entropy::Mixed ? content.size() + MIXED_SEGMENT_SIZE : size;
+			while (content.size() < segmentEnd)
+			{
+				text ? AppendWord(content) : AppendNoise(content);
+			}
+			if (entropy == Entropy::Mixed)
+			{
+				text = !text;
+			}
+		}
+		content.resize(size);
+		return content;
+	}
+
+	// Слово из случайной октавы словаря [2^k - 1, 2^(k+1) - 1): частоты убывают примерно как у закона Ципфа
+	void AppendWord(std::vector<char>& content)
+	{
+		const auto octave = uint64_t{ 1 } << Next(VOCABULARY_BITS);
+		const auto& word = m_vocabulary[octave - 1 + Next(octave)];
+		content.insert(content.end(), word.begin(), word.end());
+		content.push_back(Next(12) == 0 ? '\n' : ' ');
+	}
+
+	void AppendNoise(std::vector<char>& content)
+	{
+		const auto value = m_random();
+		for (size_t i = 0; i < sizeof(value); ++i)
+		{
+			content.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+		}
+	}
+
+	std::mt19937_64 m_random;
+	std::vector<std::string> m_vocabulary;
+};
@@ -0,0 +1,252 @@
+#include "../ArchiveExtractor.h"
+#include "../ArchiveWriter.h"
+#include "../Codec.h"
+#include "../CodecSelector.h"
+#include "../../lib/commandLine/CommandLine.h"
+#include "BenchReport.h"
+#include "Corpus.h"
+#include <chrono>
+#include <filesystem>
+#include <gsl/gsl>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+struct Args
+{
+	std::vector<unsigned> threads;
+	std::vector<std::string> codecs;
+	unsigned repeats = 5;
+	double scale = 1.0;
+	uint64_t seed = 42;
+	std::optional<std::string> csvPath;
+	std::optional<std::string> jsonPath;
+	std::optional<std::string> workDir;
+	bool keep = false;
+};
+
+// Пути внутри рабочего каталога; кроме них бенчмарк ничего там не создаёт и не удаляет
+const std::filesystem::path CORPUS_FOLDER = "corpus";
+const std::filesystem::path ARCHIVE_PATH = "bench.tar";
+const std::filesystem::path OUTPUT_FOLDER = "extracted";
+
+std::vector<std::string> SplitList(std::string const& list)
+{
+	std::vector<std::string> items;
+	std::istringstream input(list);
+	for (std::string item; std::getline(input, item, ',');)
+	{
+		if (!item.empty())
+		{
+			items.push_back(item);
+		}
+	}
+	return items;
+}
+
+// 1, 2, 4, ... до числа ядер включительно
+std::vector<unsigned> GetDefaultThreads()
+{
+	const auto cores = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<unsigned> threads;
+	for (unsigned n = 1; n < cores; n *= 2)
+	{
+		threads.push_back(n);
+	}
+	threads.push_back(cores);
+	return threads;
+}
+
+std::vector<std::string> GetDefaultCodecs()
+{
+	std::vector<std::string> codecs;
+	for (const auto id : GetAvailableCodecs())
+	{
+		codecs.emplace_back(GetCodec(id).GetName());
+	}
+	codecs.emplace_back("auto");
+	return codecs;
+}
+
+Args ParseCommandLine(const int argc, char** argv)
+{
+	std::vector<std::string> options(argv + 1, argv + argc);
+	Args args;
+	if (const auto threads = ExtractOption(options, "--threads"))
+	{
+		for (const auto& item : SplitList(*threads))
+		{
+			args.threads.push_back(static_cast<unsigned>(std::stoul(item)));
+		}
+	}
+	if (const auto codecs = ExtractOption(options, "--codecs"))
+	{
+		args.codecs = SplitList(*codecs);
+	}
+	if (const auto repeats = ExtractOption(options, "--repeat"))
+	{
+		args.repeats = static_cast<unsigned>(std::stoul(*repeats));
+	}
+	if (const auto scale = ExtractOption(options, "--scale"))
+	{
+		args.scale = std::stod(*scale);
+	}
+	if (const auto seed = ExtractOption(options, "--seed"))
+	{
+		args.seed = std::stoull(*seed);
+	}
+	args.csvPath = ExtractOption(options, "--csv");
+	args.jsonPath = ExtractOption(options, "--json");
+	args.workDir = ExtractOption(options, "--dir");
+	args.keep = ExtractFlag(options, "--keep");
+	if (!options.empty())
+	{
+		throw std::invalid_argument("Unknown option " + options.front());
+	}
+
+	if (args.threads.empty())
+	{
+		args.threads = GetDefaultThreads();
+	}
+	if (args.codecs.empty())
+	{
+		args.codecs = GetDefaultCodecs();
+	}
+	if (args.repeats == 0 || args.scale <= 0 || std::ranges::find(args.threads, 0u) != args.threads.end())
+	{
+		throw std::invalid_argument("Invalid arguments");
+	}
+	return args;
+}
+
+CodecSelector GetSelector(std::string const& codec)
+{
+	return CodecSelector(codec == "auto" ? std::nullopt : std::optional(GetCodec(codec).GetId()));
+}
+
+template <typename Fn>
+double MeasureSeconds(Fn&& fn)
+{
+	const auto start = std::chrono::steady_clock::now();
+	std::forward<Fn>(fn)();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void VerifyRoundTrip(Corpus const& corpus, std::filesystem::path const& outputFolder)
+{
+	for (const auto& file : corpus.files)
+	{
+		if (ReadFileContent(file) != ReadFileContent((outputFolder / file).string()))
+		{
+			throw std::runtime_error("Extracted file differs from the original: " + file);
+		}
+	}
+}
+
+// Каждая конфигурация повторяется repeats раз; результат первого повтора сверяется с корпусом
+std::vector<BenchResult> RunBench(Args const& args, Corpus const& corpus)
+{
+	std::vector<BenchResult> results;
+	for (const auto& codec : args.codecs)
+	{
+		const auto selector = GetSelector(codec);
+		for (const auto threads : args.threads)
+		{
+			BenchResult create{ .codec = codec, .operation = "create", .threads = threads, .rawSize = corpus.totalSize };
+			BenchResult extract{ .codec = codec, .operation = "extract", .threads = threads, .rawSize = corpus.totalSize };
+			for (unsigned repeat = 0; repeat < args.repeats; ++repeat)
+			{
+				std::filesystem::remove(ARCHIVE_PATH);
+				create.seconds.push_back(MeasureSeconds([&] {
+					WriteArchive(ARCHIVE_PATH.string(), corpus.files, threads, selector);
+				}));
+				create.archiveSize = extract.archiveSize = std::filesystem::file_size(ARCHIVE_PATH);
+
+				std::filesystem::remove_all(OUTPUT_FOLDER);
+				std::filesystem::create_directories(OUTPUT_FOLDER);
+				extract.seconds.push_back(MeasureSeconds([&] {
+					ExtractArchive(ARCHIVE_PATH.string(), OUTPUT_FOLDER.string(), threads);
+				}));
+				if (repeat == 0)
+				{
+					VerifyRoundTrip(corpus, OUTPUT_FOLDER);
+				}
+			}
+			std::cout << codec << " x" << threads << ": create " << create.GetMedian() << "s, extract " << extract.GetMedian() << "s" << std::endl;
+			results.push_back(std::move(create));
+			results.push_back(std::move(extract));
+		}
+	}
+	std::filesystem::remove(ARCHIVE_PATH);
+	std::filesystem::remove_all(OUTPUT_FOLDER);
+
+	ComputeSpeedup(results);
+	return results;
+}
+
+int main(const int argc, char** argv)
+{
+	try
+	{
+		const auto args = ParseCommandLine(argc, argv);
+		const auto initialDir = std::filesystem::current_path();
+		const auto workDir = args.workDir
+			? std::filesystem::absolute(*args.workDir)
+			: std::filesystem::temp_directory_path() / ("archive-bench-" + std::to_string(getpid()));
+		// в существующем каталоге (--dir .) удаляются только свои пути, и они не должны затирать чужие
+		const bool createdWorkDir = std::filesystem::create_directories(workDir);
+		for (const auto& path : { CORPUS_FOLDER, ARCHIVE_PATH, OUTPUT_FOLDER })
+		{
+			if (!createdWorkDir && std::filesystem::exists(workDir / path))
+			{
+				throw std::invalid_argument((workDir / path).string() + " already exists");
+			}
+		}
+		auto cleanup = gsl::finally([&] {
+			// деструктор не должен бросать, поэтому ошибки очистки игнорируются
+			std::error_code error;
+			std::filesystem::current_path(initialDir, error);
+			if (args.keep)
+			{
+				return;
+			}
+			if (createdWorkDir)
+			{
+				std::filesystem::remove_all(workDir, error);
+				return;
+			}
+			for (const auto& path : { CORPUS_FOLDER, ARCHIVE_PATH, OUTPUT_FOLDER })
+			{
+				std::filesystem::remove_all(workDir / path, error);
+			}
+		});
+		// относительные пути в архиве и при сверке не зависят от расположения рабочего каталога
+		std::filesystem::current_path(workDir);
+
+		CorpusGenerator generator(args.seed);
+		const auto corpus = generator.Generate(CORPUS_FOLDER, GetDefaultCorpusGroups(args.scale));
+		std::cout << "Corpus: " << corpus.files.size() << " files, " << corpus.totalSize << " bytes in " << workDir << std::endl;
+
+		const auto results = RunBench(args, corpus);
+		std::filesystem::current_path(initialDir);
+		PrintResults(std::cout, results);
+		const BenchCorpusInfo corpusInfo{ args.seed, args.scale, corpus.files.size(), corpus.totalSize };
+		if (args.csvPath)
+		{
+			WriteCsv(*args.csvPath, results);
+		}
+		if (args.jsonPath)
+		{
+			WriteJson(*args.jsonPath, corpusInfo, results);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -1,16 +1,21 @@
-#include "../ChunkVector.h"
-#include "../Gzip.h"
+#include "../ArchiveExtractor.h"
+#include "../ArchiveIndex.h"
+#include "../Codec.h"
+#include "../FileContent.h"
+#include "../LoadImbalance.h"
 #include "../Timer.h"
-#include "../WaitChildProcesses.h"
-#include <sstream>
 #include <filesystem>
 #include <gsl/gsl>
+#include <optional>
+#include <sys/mman.h>
 
 struct Args
 {
 	std::string archiveName;
 	int numProcesses;
 	std::string outputFolder;
+	std::optional<std::string> member{};
+	bool useMmap = false;
 };
 
 Args ParseCommandLine(const int argc, char** argv)
@@ -49,84 +54,103 @@ Args ParseCommandLine(const int argc, char** argv)
 		};
 	}
 
+	if (mode == "--member")
+	{
+		const bool useMmap = argc == 6 && std::string(argv[3]) == "--mmap";
+		if (argc != (useMmap ? 6 : 5))
+		{
+			throw std::invalid_argument("Wrong number of arguments");
+		}
+
+		return Args
+		{
+			.archiveName = argv[argc - 2],
+			.numProcesses = 0,
+			.outputFolder = argv[argc - 1],
+			.member = argv[2],
+			.useMmap = useMmap,
+		};
+	}
+
 	throw std::invalid_argument("Invalid arguments");
 }
 
-void UnpackArchive(std::string const& archiveName, std::string const& outputFolder)
+void ExtractFiles(const Args& args)
 {
-	std::stringstream command;
-	command << "tar -xf " << archiveName << ".tar -C " << outputFolder;
-	if (system(command.str().c_str()) != 0)
+	Timer timer(std::cout, "ExtractFiles");
+	const auto busyTimes = ExtractArchive(args.archiveName + ".tar", args.outputFolder, args.numProcesses + 1);
+	timer.Stop();
+
+	std::vector<std::chrono::milliseconds::rep> loads;
+	for (const auto busyTime : busyTimes)
 	{
-		throw std::runtime_error("Error extracting tar archive");
+		loads.push_back(busyTime.count());
 	}
+	PrintLoadImbalance(std::cout, "ExtractFiles", loads, "ms");
 }
 
-void ExtractFiles(const Args& mode)
+std::vector<char> ReadMemberData(FileDesc const& archive, IndexEntry const& entry, const bool useMmap)
 {
-	Timer timer(std::cout, "ExtractFiles");
-	pid_t pid = getpid();
-	std::vector<pid_t> childPids;
-	auto finalizer = gsl::finally([&] {
-		if (pid != 0)
-		{
-			WaitChildProcesses(childPids);
-		}
-	});
-	std::vector<std::string> files;
-
-	Timer seqTimer(std::cout, "SequentialPart");
-	UnpackArchive(mode.archiveName, mode.outputFolder);
-	seqTimer.Stop();
+	auto const& codec = GetCodec(static_cast<CodecId>(entry.codec));
+	if (!useMmap)
+	{
+		return codec.Decompress(ReadFileRange(archive, entry.offset, entry.compressedSize), entry.rawSize);
+	}
 
-	for (const auto& file : std::filesystem::directory_iterator(mode.outputFolder))
+	// mmap требует выровненного на страницу смещения
+	const auto pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+	const auto mapOffset = entry.offset / pageSize * pageSize;
+	const auto mapSize = entry.offset - mapOffset + entry.compressedSize;
+	void* mapped = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, archive.Get(), static_cast<off_t>(mapOffset));
+	if (mapped == MAP_FAILED)
 	{
-		if (file.path().extension() == ".gz")
-		{
-			files.push_back(file.path().string());
-		}
+		throw std::system_error(errno, std::generic_category(), "Error mapping archive");
 	}
+	auto unmap = gsl::finally([&] {
+		munmap(mapped, mapSize);
+	});
+	madvise(mapped, mapSize, MADV_SEQUENTIAL);
 
-	const auto chunkSize = std::max<size_t>(files.size() / (mode.numProcesses + 1), 1);
-	const auto chunks = ChunkVector(files, chunkSize);
+	return codec.Decompress({ static_cast<const char*>(mapped) + (entry.offset - mapOffset), entry.compressedSize }, entry.rawSize);
+}
 
-	for (int i = 0; i < chunks.size() - 1 && pid != 0; i++)
+void ExtractMember(const Args& args)
+{
+	Timer timer(std::cout, "ExtractMember");
+	const auto archive = OpenFile(args.archiveName + ".tar", O_RDONLY);
+	const auto index = ReadIndex(archive);
+	if (!index)
 	{
-		pid = fork();
-		childPids.emplace_back(pid);
-		if (pid == -1)
-		{
-			throw std::runtime_error("Error forking process");
-		}
-		if (pid == 0)
-		{
-			GzipFiles("-d", chunks.at(i));
-			exit(0);
-		}
+		throw std::runtime_error("Archive has no index: " + args.archiveName);
+	}
+	const auto entry = FindIndexEntry(*index, *args.member);
+	if (!entry)
+	{
+		throw std::runtime_error("No such member in archive: " + *args.member);
 	}
 
-	if (pid != 0)
+	const auto data = ReadMemberData(archive, *entry, args.useMmap);
+	if (data.size() != entry->rawSize || crc32_z(crc32(0, nullptr, 0), reinterpret_cast<const Bytef*>(data.data()), data.size()) != entry->crc)
 	{
-		auto deleteFilesFinalizer = gsl::finally([&] {
-			for (const auto& file : std::filesystem::directory_iterator(mode.outputFolder))
-			{
-				std::remove(file.path().c_str());
-			}
-		});
-		GzipFiles("-d", chunks.back());
-		WaitChildProcesses(childPids);
-		timer.Stop();
+		throw std::runtime_error("Checksum mismatch for member " + entry->name);
 	}
+
+	const auto path = GetOutputPath(args.outputFolder, entry->name, GetCodec(CodecId::Store));
+	std::filesystem::create_directories(path.parent_path());
+	WriteFileContent(path, data);
 }
 
 int main(const int argc, char** argv)
 {
 	try
 	{
-		auto args = ParseCommandLine(argc, argv);
-		for (int i = 0; i <= 20; ++i)
+		const auto args = ParseCommandLine(argc, argv);
+		if (args.member)
+		{
+			ExtractMember(args);
+		}
+		else
 		{
-			args.numProcesses = i;
 			ExtractFiles(args);
 		}
 	}
@@ -1,149 +1,172 @@
-#include "../ChunkVector.h"
-#include "../Gzip.h"
+#include "../ArchiveWriter.h"
+#include "../Codec.h"
+#include "../CodecSelector.h"
+#include "../IncrementalArchive.h"
+#include "../LoadImbalance.h"
+#include "../ProcessCompression.h"
 #include "../Timer.h"
-#include "../WaitChildProcesses.h"
-#include <sstream>
-#include <gsl/gsl>
+#ifdef ARCHIVE_WITH_URING
+#include "../UringPipeline.h"
+#endif
+#include "../../lib/commandLine/CommandLine.h"
+#include <algorithm>
+#include <filesystem>
+#include <optional>
 
 struct Args
 {
 	std::string archiveName;
 	int numProcesses;
 	std::vector<std::string> files;
+	std::optional<CodecId> codec = CodecId::Deflate;
+	bool useProcesses = false;
+	std::optional<std::string> incrementalBase;
+	bool useIoUring = false;
 };
 
+// --codec <gzip|zstd|lz4|store|auto>
+std::optional<CodecId> ParseCodecOption(std::vector<std::string>& args)
+{
+	const auto name = ExtractOption(args, "--codec");
+	if (!name)
+	{
+		return CodecId::Deflate;
+	}
+	return *name == "auto" ? std::nullopt : std::optional(GetCodec(*name).GetId());
+}
+
 Args ParseCommandLine(const int argc, char** argv)
 {
-	if (argc < 4)
+	std::vector<std::string> args(argv + 1, argv + argc);
+	const auto codec = ParseCodecOption(args);
+	// --processes: сжимать в рабочих процессах вместо потоков
+	const bool useProcesses = ExtractFlag(args, "--processes");
+	// --incremental <предыдущий архив>: не пересжимать файлы, содержимое которых в нём уже есть
+	const auto incrementalBase = ExtractOption(args, "--incremental");
+	// --io-uring: читать файлы и писать архив через io_uring
+	const bool useIoUring = ExtractFlag(args, "--io-uring");
+	if (useIoUring && (useProcesses || incrementalBase))
+	{
+		throw std::invalid_argument("--io-uring can not be combined with --processes or --incremental");
+	}
+	if (args.size() < 3)
 	{
 		throw std::invalid_argument("Wrong number of arguments");
 	}
 
-	std::vector<std::string> files;
-
-	const std::string mode(argv[1]);
+	const std::string mode(args[0]);
 
 	if (mode == "-S")
 	{
-		std::string archiveName = argv[2];
-		for (int i = 3; i < argc; i++)
-		{
-			files.emplace_back(argv[i]);
-		}
-
 		return Args
 		{
-			.archiveName = archiveName,
+			.archiveName = args[1],
 			.numProcesses = 0,
-			.files = files,
+			.files = { args.begin() + 2, args.end() },
+			.codec = codec,
+			.useProcesses = useProcesses,
+			.incrementalBase = incrementalBase,
+			.useIoUring = useIoUring,
 		};
 	}
 
 	if (mode == "-P")
 	{
-		int numProcesses = std::stoi(argv[2]);
-		std::string archiveName = argv[3];
-		for (int i = 4; i < argc; i++)
-		{
-			files.emplace_back(argv[i]);
-		}
-
 		return Args
 		{
-			.archiveName = archiveName,
-			.numProcesses = numProcesses,
-			.files = files,
+			.archiveName = args[2],
+			.numProcesses = std::stoi(args[1]),
+			.files = { args.begin() + 3, args.end() },
+			.codec = codec,
+			.useProcesses = useProcesses,
+			.incrementalBase = incrementalBase,
+			.useIoUring = useIoUring,
 		};
 	}
 
 	throw std::invalid_argument("Invalid arguments");
 }
 
-void ArchiveFiles(std::string const& archiveName, std::vector<std::string> const& files)
+template <typename Pool>
+void WriteArchiveWithPool(const Args& args, Pool& pool, const size_t maxInFlight)
 {
-	std::stringstream command;
-	command << "tar -cf " << archiveName + ".tar";
-	for (const auto& file : files)
-	{
-		command << " " << file << ".gz";
-	}
-	if (system(command.str().c_str()) != 0)
+	const CodecSelector selector(args.codec);
+	const auto archivePath = args.archiveName + ".tar";
+	if (!args.incrementalBase)
 	{
-		throw std::runtime_error("Error generating tar archive");
+		WriteArchive(archivePath, args.files, pool, maxInFlight, selector);
+		return;
 	}
+
+	const auto stats = WriteIncrementalArchive(archivePath, args.files, *args.incrementalBase + ".tar", pool, maxInFlight, selector);
+	std::cout << "Incremental: reused " << stats.reusedFiles << " files (" << stats.reusedBytes << " bytes), compressed "
+			  << stats.compressedFiles << " files" << std::endl;
 }
 
-void DeleteFiles(std::vector<std::string> const& files)
+void MakeArchiveInProcesses(const Args& args)
 {
-	for (const auto& file : files)
+	Timer timer(std::cout, "MakeArchive");
+	ProcessPool pool(std::filesystem::read_symlink("/proc/self/exe"), { COMPRESSION_WORKER_ARG }, args.numProcesses + 1);
+	WriteArchiveWithPool(args, pool, pool.GetProcessesNum() * 2);
+	timer.Stop();
+
+	PrintLoadImbalance(std::cout, "MakeArchive", pool.GetCompletedCosts(), "bytes");
+}
+
+void MakeArchiveWithUring([[maybe_unused]] const Args& args)
+{
+#ifdef ARCHIVE_WITH_URING
+	Timer timer(std::cout, "MakeArchive");
+	const auto busyTimes = WriteArchiveWithUring(args.archiveName + ".tar", args.files, args.numProcesses + 1, CodecSelector(args.codec));
+	timer.Stop();
+
+	std::vector<std::chrono::milliseconds::rep> loads;
+	for (const auto busyTime : busyTimes)
 	{
-		std::remove(file.c_str());
+		loads.push_back(busyTime.count());
 	}
+	PrintLoadImbalance(std::cout, "MakeArchive", loads, "ms");
+#else
+	throw std::runtime_error("make-archive is built without io_uring support");
+#endif
 }
 
 void MakeArchive(const Args& args)
 {
-	Timer timer(std::cout, "MakeArchive");
-	pid_t pid = getpid();
-	std::vector<pid_t> childPids;
-	auto finalizer = gsl::finally([&] {
-		if (pid != 0)
-		{
-			WaitChildProcesses(childPids);
-		}
-	});
-	const auto chunkSize = std::max<size_t>(args.files.size() / (args.numProcesses + 1), 1);
-	const auto chunks = ChunkVector(args.files, chunkSize);
-	for (int i = 0; i < chunks.size() - 1 && pid != 0; i++)
+	if (args.useProcesses)
 	{
-		pid = fork();
-		childPids.emplace_back(pid);
-		if (pid == -1)
-		{
-			// Если выбросится исключение, то кто-то должен дождаться завершения дочерних процессов (Исправлено)
-			throw std::runtime_error("Error forking process");
-		}
-		if (pid == 0)
-		{
-			GzipFiles("-k", chunks.at(i));
-		}
+		MakeArchiveInProcesses(args);
+		return;
 	}
-
-	if (pid != 0)
+	if (args.useIoUring)
 	{
-		GzipFiles("-k", chunks.back());
-		WaitChildProcesses(childPids);
-
-		ArchiveFiles(args.archiveName, args.files);
-		timer.Stop();
-
-		std::vector<std::string> zippedFiles;
-		// В другое место и захватывать по ссылке (Исправлено)
-		auto deleteFilesFinalizer = gsl::finally([&] {
-			// Удалить файлы в finalizer(исправлено)
-			DeleteFiles(zippedFiles);
-			DeleteFiles({ args.archiveName + ".tar" });
-		});
-
-		zippedFiles.reserve(args.files.size());
-		for (const auto& file : args.files)
-		{
-			zippedFiles.emplace_back(file + ".gz");
-		}
+		MakeArchiveWithUring(args);
+		return;
+	}
 
+	Timer timer(std::cout, "MakeArchive");
+	WorkerPool pool(args.numProcesses + 1);
+	WriteArchiveWithPool(args, pool, pool.GetThreadsNum() * 2);
+	timer.Stop();
+
+	std::vector<std::chrono::milliseconds::rep> loads;
+	for (const auto busyTime : pool.GetBusyTimes())
+	{
+		loads.push_back(busyTime.count());
 	}
+	PrintLoadImbalance(std::cout, "MakeArchive", loads, "ms");
 }
 
 int main(const int argc, char** argv)
 {
+	if (argc == 2 && argv[1] == COMPRESSION_WORKER_ARG)
+	{
+		return RunCompressionWorker();
+	}
+
 	try
 	{
-		auto args = ParseCommandLine(argc, argv);
-		for (int i = 0; i <= 20; ++i)
-		{
-			args.numProcesses = i;
-			MakeArchive(args);
-		}
+		MakeArchive(ParseCommandLine(argc, argv));
 	}
 	catch (const std::exception& e)
 	{
@@ -0,0 +1,376 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../ArchiveExtractor.h"
+#include "../ArchiveIndex.h"
+#include "../ArchiveWriter.h"
+#include "../Codec.h"
+#include "../CodecSelector.h"
+#include "../FileContent.h"
+#include "../Gzip.h"
+#include "../IncrementalArchive.h"
+#include "../TarReader.h"
+#include "../TarWriter.h"
+#include "../WorkerPool.h"
+#include <filesystem>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+// Текст с повторами вперемешку со случайными байтами: сжимается, но не вырождается
+std::vector<char> MakeData(const size_t size, const unsigned seed)
+{
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<int> byte(0, 255);
+	const std::string words[] = { "archive ", "member ", "codec ", "index ", "block " };
+	std::vector<char> data;
+	data.reserve(size);
+	while (data.size() < size)
+	{
+		if (byte(gen) < 32)
+		{
+			data.push_back(static_cast<char>(byte(gen)));
+			continue;
+		}
+		const auto& word = words[byte(gen) % std::size(words)];
+		data.insert(data.end(), word.begin(), word.end());
+	}
+	data.resize(size);
+	return data;
+}
+
+// Каталог во временной папке, удаляется вместе с содержимым
+class TempDir
+{
+public:
+	TempDir()
+		: m_path(std::filesystem::temp_directory_path() / ("archive-tests-" + std::to_string(getpid()) + "-" + std::to_string(s_counter++)))
+	{
+		std::filesystem::create_directories(m_path);
+	}
+
+	TempDir(const TempDir&) = delete;
+	TempDir& operator=(const TempDir&) = delete;
+
+	~TempDir()
+	{
+		std::error_code error;
+		std::filesystem::remove_all(m_path, error);
+	}
+
+	[[nodiscard]] std::string operator/(std::string const& name) const
+	{
+		return (m_path / name).string();
+	}
+
+private:
+	inline static int s_counter = 0;
+	std::filesystem::path m_path;
+};
+
+// Пишет файлы name -> содержимое, возвращает их пути
+std::vector<std::string> WriteFiles(TempDir const& dir, std::vector<std::pair<std::string, std::vector<char>>> const& files)
+{
+	std::vector<std::string> paths;
+	for (const auto& [name, content] : files)
+	{
+		const auto path = dir / name;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+		WriteFileContent(path, content);
+		paths.push_back(path);
+	}
+	return paths;
+}
+
+// Распакованный файл лежит в outputFolder по пути члена, то есть по исходному пути без ведущего '/'
+std::string GetExtractedPath(std::string const& outputFolder, std::string const& file)
+{
+	return (std::filesystem::path(outputFolder) / std::filesystem::path(file).relative_path()).string();
+}
+} // namespace
+
+TEST_CASE("every codec restores compressed data")
+{
+	for (const auto id : GetAvailableCodecs())
+	{
+		auto const& codec = GetCodec(id);
+		INFO("codec " << codec.GetName());
+		for (const auto size : { size_t{ 0 }, size_t{ 1 }, size_t{ 1000 }, size_t{ 300'000 } })
+		{
+			const auto data = MakeData(size, static_cast<unsigned>(size));
+			const auto compressed = codec.Compress(data);
+			REQUIRE(codec.Decompress(compressed, data.size()) == data);
+		}
+	}
+}
+
+TEST_CASE("blocks compressed separately decompress as one stream")
+{
+	const auto data = MakeData(1'000'000, 7);
+	constexpr size_t blockSize = 128 * 1024;
+	constexpr size_t dictionarySize = 32 * 1024;
+	for (const auto id : GetAvailableCodecs())
+	{
+		auto const& codec = GetCodec(id);
+		INFO("codec " << codec.GetName());
+		auto stream = codec.StreamHeader();
+		for (size_t start = 0; start < data.size(); start += blockSize)
+		{
+			const auto end = std::min(start + blockSize, data.size());
+			const auto dictionaryStart = start - std::min(start, dictionarySize);
+			const auto block = codec.CompressBlock(std::span(data).subspan(start, end - start),
+				std::span(data).subspan(dictionaryStart, start - dictionaryStart), end == data.size());
+			stream.insert(stream.end(), block.begin(), block.end());
+		}
+		const auto crc = crc32(0, reinterpret_cast<const Bytef*>(data.data()), static_cast<uInt>(data.size()));
+		const auto trailer = codec.StreamTrailer(crc, data.size());
+		stream.insert(stream.end(), trailer.begin(), trailer.end());
+
+		REQUIRE(codec.Decompress(stream, data.size()) == data);
+	}
+}
+
+TEST_CASE("truncated compressed data is an error")
+{
+	const auto data = MakeData(200'000, 3);
+	for (const auto id : GetAvailableCodecs())
+	{
+		if (id == CodecId::Store)
+		{
+			continue;
+		}
+		auto const& codec = GetCodec(id);
+		INFO("codec " << codec.GetName());
+		auto compressed = codec.Compress(data);
+		compressed.resize(compressed.size() / 2);
+		REQUIRE_THROWS(codec.Decompress(compressed, data.size()));
+	}
+}
+
+TEST_CASE("gzip reads concatenated members and rejects trailing data")
+{
+	const auto first = MakeData(5000, 1);
+	const auto second = MakeData(7000, 2);
+	auto compressed = GzipCompress(first);
+	const auto secondCompressed = GzipCompress(second);
+	compressed.insert(compressed.end(), secondCompressed.begin(), secondCompressed.end());
+
+	auto expected = first;
+	expected.insert(expected.end(), second.begin(), second.end());
+	REQUIRE(GzipDecompress(compressed) == expected);
+
+	SECTION("garbage after the last member")
+	{
+		compressed.insert(compressed.end(), { 'j', 'u', 'n', 'k' });
+		REQUIRE_THROWS_AS(GzipDecompress(compressed), std::runtime_error);
+	}
+
+	SECTION("last member is cut")
+	{
+		compressed.resize(compressed.size() - 3);
+		REQUIRE_THROWS_AS(GzipDecompress(compressed), std::runtime_error);
+	}
+}
+
+TEST_CASE("tar writer output is read back member by member")
+{
+	const TempDir dir;
+	const auto archivePath = dir / "members.tar";
+	const std::string longName = "dir/" + std::string(150, 'n') + "/file.txt";
+	const auto small = MakeData(100, 1);
+	const auto streamed = MakeData(3000, 2);
+	{
+		auto output = OpenFile(archivePath, O_WRONLY | O_CREAT | O_TRUNC);
+		TarWriter writer(output);
+		writer.AddFile({ .name = "/abs/small.txt", .mode = 0600 }, small);
+		writer.AddFile({ .name = longName, .paxRecords = { { CODEC_PAX_KEY, "store" } } }, {});
+		writer.BeginFile({ .name = "streamed.bin" });
+		writer.AppendData(std::span(streamed).first(1000));
+		writer.AppendData(std::span(streamed).subspan(1000));
+		writer.EndFile();
+		writer.Finish();
+	}
+
+	auto input = OpenFile(archivePath, O_RDONLY);
+	TarReader reader(input);
+	auto member = reader.Next();
+	REQUIRE(member);
+	REQUIRE(member->name == "abs/small.txt");
+	REQUIRE(member->mode == 0600);
+	REQUIRE(reader.ReadData(*member) == small);
+
+	member = reader.Next();
+	REQUIRE(member);
+	REQUIRE(member->name == longName);
+	REQUIRE(member->size == 0);
+	REQUIRE(member->codec == "store");
+
+	member = reader.Next();
+	REQUIRE(member);
+	REQUIRE(member->name == "streamed.bin");
+	REQUIRE(reader.ReadData(*member) == streamed);
+
+	REQUIRE_FALSE(reader.Next());
+}
+
+TEST_CASE("tar reader rejects truncated archives and oversized headers")
+{
+	const TempDir dir;
+	const auto archivePath = dir / "members.tar";
+	{
+		auto output = OpenFile(archivePath, O_WRONLY | O_CREAT | O_TRUNC);
+		TarWriter writer(output);
+		// член больше буфера читателя: непрочитанные данные пропускаются через lseek
+		writer.AddFile({ .name = "large.bin" }, MakeData(3 << 20, 1));
+		writer.AddFile({ .name = "small.txt" }, MakeData(100, 2));
+		writer.Finish();
+	}
+	std::filesystem::resize_file(archivePath, 2 << 20);
+	{
+		auto input = OpenFile(archivePath, O_RDONLY);
+		TarReader reader(input);
+		REQUIRE(reader.Next());
+		REQUIRE_THROWS_AS(reader.Next(), std::runtime_error);
+	}
+
+	{
+		auto output = OpenFile(archivePath, O_WRONLY | O_CREAT | O_TRUNC);
+		TarWriter writer(output);
+		writer.AddFile({ .name = "a.txt", .paxRecords = { { CODEC_PAX_KEY, std::string(MAX_TAR_EXTENDED_HEADER_SIZE, 'x') } } }, {});
+		writer.Finish();
+	}
+	auto input = OpenFile(archivePath, O_RDONLY);
+	TarReader reader(input);
+	REQUIRE_THROWS_AS(reader.Next(), std::runtime_error);
+}
+
+TEST_CASE("archive index survives serialization")
+{
+	const std::vector<IndexEntry> entries{
+		{ .name = "a.txt.gz", .offset = 512, .compressedSize = 100, .rawSize = 300, .crc = 0xdeadbeef, .codec = 1, .contentHash = 42 },
+		{ .name = std::string(300, 'x'), .offset = uint64_t{ 1 } << 40, .compressedSize = 0, .rawSize = 0, .crc = 0, .codec = 0, .contentHash = 0 },
+	};
+	const auto data = SerializeIndex(entries, 4096);
+	REQUIRE(data.size() % TAR_BLOCK_SIZE == 0);
+
+	const auto parsed = ParseIndex(data);
+	REQUIRE(parsed.size() == entries.size());
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		REQUIRE(parsed[i].name == entries[i].name);
+		REQUIRE(parsed[i].offset == entries[i].offset);
+		REQUIRE(parsed[i].compressedSize == entries[i].compressedSize);
+		REQUIRE(parsed[i].rawSize == entries[i].rawSize);
+		REQUIRE(parsed[i].crc == entries[i].crc);
+		REQUIRE(parsed[i].codec == entries[i].codec);
+		REQUIRE(parsed[i].contentHash == entries[i].contentHash);
+	}
+	REQUIRE_THROWS(ParseIndex(std::span(data).first(4)));
+}
+
+TEST_CASE("archive roundtrip restores files and writes an index")
+{
+	const TempDir dir;
+	// последний файл больше STREAMED_MEMBER_SIZE: сжимается блоками и распаковывается потоково
+	const auto files = WriteFiles(dir, {
+		{ "in/empty.txt", {} },
+		{ "in/text.txt", MakeData(10'000, 1) },
+		{ "in/nested/data.bin", MakeData(1'000'000, 2) },
+		{ "in/large.bin", MakeData(STREAMED_MEMBER_SIZE + 12345, 3) },
+	});
+
+	for (const auto id : GetAvailableCodecs())
+	{
+		INFO("codec " << GetCodec(id).GetName());
+		const auto archivePath = dir / "archive.tar";
+		const auto outputFolder = dir / "out";
+		WriteArchive(archivePath, files, 2, CodecSelector(id));
+
+		const auto index = ReadIndex(OpenFile(archivePath, O_RDONLY));
+		REQUIRE(index);
+		REQUIRE(index->size() == files.size());
+		for (const auto& file : files)
+		{
+			const auto entry = std::ranges::find_if(*index, [&](IndexEntry const& e) {
+				return GetOutputPath("", e.name, GetCodec(static_cast<CodecId>(e.codec))) == std::filesystem::path(file).relative_path();
+			});
+			REQUIRE(entry != index->end());
+			REQUIRE(entry->rawSize == std::filesystem::file_size(file));
+			REQUIRE(entry->contentHash == HashFileContent(file));
+		}
+
+		ExtractArchive(archivePath, outputFolder, 2);
+		for (const auto& file : files)
+		{
+			REQUIRE(ReadFileContent(GetExtractedPath(outputFolder, file)) == ReadFileContent(file));
+		}
+		std::filesystem::remove_all(outputFolder);
+	}
+}
+
+TEST_CASE("extraction reports the error of a corrupted member")
+{
+	const TempDir dir;
+	std::vector<std::pair<std::string, std::vector<char>>> contents;
+	for (unsigned i = 0; i < 8; ++i)
+	{
+		contents.emplace_back("in/" + std::to_string(i) + ".txt", MakeData(20'000, i));
+	}
+	const auto files = WriteFiles(dir, contents);
+	const auto archivePath = dir / "archive.tar";
+	WriteArchive(archivePath, files, 2, CodecSelector(CodecId::Deflate));
+	const auto archive = ReadFileContent(archivePath);
+	const auto index = ReadIndex(OpenFile(archivePath, O_RDONLY));
+	REQUIRE(index);
+
+	// первый член падает, пока заполняется окно заданий, последний - при ожидании оставшихся
+	for (const auto i : { size_t{ 0 }, index->size() - 1 })
+	{
+		auto const& corrupted = (*index)[i];
+		INFO("corrupted member " << corrupted.name);
+		auto data = archive;
+		for (auto pos = corrupted.offset + corrupted.compressedSize / 2; pos < corrupted.offset + corrupted.compressedSize / 2 + 16; ++pos)
+		{
+			data[pos] = static_cast<char>(~data[pos]);
+		}
+		const auto corruptedPath = dir / "corrupted.tar";
+		WriteFileContent(corruptedPath, data);
+		// std::future_error - logic_error, то есть настоящая ошибка распаковки потерялась бы
+		REQUIRE_THROWS_AS(ExtractArchive(corruptedPath, dir / "out", 1), std::runtime_error);
+	}
+}
+
+TEST_CASE("incremental archive reuses unchanged members")
+{
+	const TempDir dir;
+	auto files = WriteFiles(dir, {
+		{ "in/a.txt", MakeData(50'000, 1) },
+		{ "in/b.txt", MakeData(60'000, 2) },
+		{ "in/c.txt", MakeData(70'000, 3) },
+	});
+	const auto basePath = dir / "base.tar";
+	WriteArchive(basePath, files, 2, CodecSelector(CodecId::Deflate));
+
+	WriteFileContent(files[1], MakeData(60'000, 20));
+	// переименованный файл узнаётся по содержимому
+	const auto renamed = dir / "in/renamed.txt";
+	std::filesystem::rename(files[2], renamed);
+	files[2] = renamed;
+
+	const auto archivePath = dir / "incremental.tar";
+	WorkerPool pool(2);
+	const auto stats = WriteIncrementalArchive(archivePath, files, basePath, pool, 4, CodecSelector(CodecId::Deflate));
+	REQUIRE(stats.reusedFiles == 2);
+	REQUIRE(stats.compressedFiles == 1);
+	REQUIRE(stats.reusedBytes == 50'000 + 70'000);
+
+	const auto outputFolder = dir / "out";
+	ExtractArchive(archivePath, outputFolder, 2);
+	for (const auto& file : files)
+	{
+		REQUIRE(ReadFileContent(GetExtractedPath(outputFolder, file)) == ReadFileContent(file));
+	}
+	REQUIRE_THROWS_AS(WriteIncrementalArchive(basePath, files, basePath, pool, 4, CodecSelector(CodecId::Deflate)), std::invalid_argument);
+}
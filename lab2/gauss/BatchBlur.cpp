@@ -0,0 +1,214 @@
+#include "BatchBlur.h"
+#include "../parallel/BoundedQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <wx/wx.h>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// wxImage разделяет данные через неатомарный счётчик ссылок, поэтому между потоками передаётся
+// владение единственным объектом, а не его копия
+struct BatchImage
+{
+	std::filesystem::path outputPath;
+	std::unique_ptr<wxImage> image;
+};
+
+// Суммарное время, которое потоки стадии были заняты работой, а не ожиданием очередей
+struct StageStats
+{
+	std::string name;
+	int threadsNum;
+	std::atomic<Clock::rep> busy = 0;
+
+	template <typename Fn>
+	decltype(auto) Measure(Fn&& fn)
+	{
+		const auto start = Clock::now();
+		struct Finish
+		{
+			StageStats& stats;
+			Clock::time_point start;
+
+			~Finish()
+			{
+				stats.busy += (Clock::now() - start).count();
+			}
+		} finish{ *this, start };
+		return fn();
+	}
+};
+
+class BatchErrors
+{
+public:
+	void Add(std::filesystem::path const& path, std::string const& message)
+	{
+		std::lock_guard lock(m_mutex);
+		m_errors.push_back(path.string() + ": " + message);
+	}
+
+	[[nodiscard]] std::vector<std::string> const& Get() const
+	{
+		return m_errors;
+	}
+
+private:
+	std::mutex m_mutex;
+	std::vector<std::string> m_errors;
+};
+
+std::vector<std::filesystem::path> ListImages(std::filesystem::path const& dir)
+{
+	std::vector<std::filesystem::path> result;
+	for (const auto& entry : std::filesystem::directory_iterator(dir))
+	{
+		auto extension = entry.path().extension().string();
+		std::ranges::transform(extension, extension.begin(), [](const unsigned char c) { return std::tolower(c); });
+		if (entry.is_regular_file() && (extension == ".jpg" || extension == ".jpeg" || extension == ".png"))
+		{
+			result.push_back(entry.path());
+		}
+	}
+	std::ranges::sort(result);
+	return result;
+}
+
+// Запускает threadsNum потоков fn и ждёт их завершения
+template <typename Fn>
+void RunStage(const int threadsNum, Fn const& fn)
+{
+	std::vector<std::jthread> threads;
+	for (int i = 0; i < std::max(threadsNum, 1); ++i)
+	{
+		threads.emplace_back(fn);
+	}
+}
+
+void PrintStats(std::vector<StageStats const*> const& stages, const size_t imagesNum, const Clock::duration wallTime)
+{
+	const auto seconds = std::chrono::duration<double>(wallTime).count();
+	std::cout << "Batch: " << imagesNum << " images in " << std::fixed << std::setprecision(3) << seconds << "s, "
+			  << std::setprecision(1) << (seconds > 0 ? imagesNum / seconds : 0.0) << " images/s" << std::endl;
+	for (const auto* stage : stages)
+	{
+		const auto busy = std::chrono::duration<double>(Clock::duration(stage->busy.load())).count();
+		const auto utilisation = seconds > 0 ? busy / (seconds * stage->threadsNum) : 0.0;
+		std::cout << "  " << stage->name << ": " << stage->threadsNum << " threads, utilisation "
+				  << std::setprecision(1) << utilisation * 100 << "%" << std::endl;
+	}
+	std::cout.unsetf(std::ios::floatfield);
+}
+} // namespace
+
+void BlurBatch(BatchArgs const& args)
+{
+	wxInitializer wxInit;
+	if (!wxInit)
+	{
+		throw std::runtime_error("Failed to initialize wxWidgets.");
+	}
+	wxImage::AddHandler(new wxJPEGHandler());
+	wxImage::AddHandler(new wxPNGHandler());
+
+	const auto files = ListImages(args.inputDir);
+	std::filesystem::create_directories(args.outputDir);
+
+	StageStats decodeStats{ .name = "decode", .threadsNum = std::max(args.decodeThreads, 1) };
+	StageStats blurStats{ .name = "blur", .threadsNum = std::max(args.blurThreads, 1) };
+	StageStats encodeStats{ .name = "encode", .threadsNum = std::max(args.encodeThreads, 1) };
+	// по два изображения на поток следующей стадии: хватает, чтобы она не простаивала, и ограничивает память
+	BoundedQueue<BatchImage> decoded(2 * blurStats.threadsNum);
+	BoundedQueue<BatchImage> blurred(2 * encodeStats.threadsNum);
+	BatchErrors errors;
+	std::atomic<size_t> nextFile = 0;
+	std::atomic<size_t> written = 0;
+
+	const auto start = Clock::now();
+	{
+		std::jthread decodeStage([&] {
+			RunStage(decodeStats.threadsNum, [&] {
+				for (auto i = nextFile++; i < files.size(); i = nextFile++)
+				{
+					try
+					{
+						auto image = decodeStats.Measure([&] {
+							return std::make_unique<wxImage>(files[i].string(), wxBITMAP_TYPE_ANY);
+						});
+						if (!image->IsOk())
+						{
+							throw std::runtime_error("Image loading failed.");
+						}
+						decoded.Push({ std::filesystem::path(args.outputDir) / files[i].filename(), std::move(image) });
+					}
+					catch (const std::exception& e)
+					{
+						errors.Add(files[i], e.what());
+					}
+				}
+			});
+			decoded.Close();
+		});
+
+		std::jthread blurStage([&] {
+			RunStage(blurStats.threadsNum, [&] {
+				// каждый поток размывает своё изображение целиком: для потока маленьких картинок
+				// параллелизм по изображениям выгоднее, чем деление одного изображения
+				ThreadPool pool(1);
+				while (auto item = decoded.Pop())
+				{
+					try
+					{
+						blurStats.Measure([&] {
+							item->image = std::make_unique<wxImage>(BlurParallel(*item->image, args.radius, pool, args.mode));
+						});
+						blurred.Push(std::move(*item));
+					}
+					catch (const std::exception& e)
+					{
+						errors.Add(item->outputPath, e.what());
+					}
+				}
+			});
+			blurred.Close();
+		});
+
+		RunStage(encodeStats.threadsNum, [&] {
+			while (auto item = blurred.Pop())
+			{
+				try
+				{
+					const auto saved = encodeStats.Measure([&] {
+						return item->image->SaveFile(item->outputPath.string());
+					});
+					if (!saved)
+					{
+						throw std::runtime_error("Failed to save image.");
+					}
+					++written;
+				}
+				catch (const std::exception& e)
+				{
+					errors.Add(item->outputPath, e.what());
+				}
+			}
+		});
+	}
+
+	PrintStats({ &decodeStats, &blurStats, &encodeStats }, written, Clock::now() - start);
+	for (const auto& error : errors.Get())
+	{
+		std::cout << error << std::endl;
+	}
+}
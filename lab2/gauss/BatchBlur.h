@@ -0,0 +1,18 @@
+#pragma once
+#include "Gauss.h"
+#include <string>
+
+// Размытие всех изображений каталога конвейером: чтение и декодирование, размытие, кодирование и запись.
+// Стадии работают в своих потоках и связаны очередями ограниченной длины
+struct BatchArgs
+{
+	std::string inputDir;
+	std::string outputDir;
+	int radius;
+	int decodeThreads;
+	int blurThreads;
+	int encodeThreads;
+	BlurMode mode = BlurMode::Tiled;
+};
+
+void BlurBatch(BatchArgs const& args);
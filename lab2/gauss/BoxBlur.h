@@ -0,0 +1,62 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <vector>
+
+// Каскад из BOX_BLUR_PASSES равномерных фильтров приближает гауссиан с тем же sigma (центральная предельная теорема).
+// Каждый проход - скользящая сумма, поэтому стоимость на пиксель не зависит от радиуса.
+// Отличие ядра каскада от точного (сумма модулей разностей весов, L1) для radius = 3.29 * sigma:
+// radius 5..10 - до 0.09, radius 20..200 - 0.05..0.065; при radius < 5 ширины округляются грубо, L1 до 0.37.
+// L1 ограничивает ошибку одного прохода в линейной яркости, для двух проходов - 2 * L1.
+// На изображениях gauss-bench (radius 5..200) отличие от точного размытия после перевода в 8 бит: PSNR 44-52 dB,
+// максимум 12-35 уровней из 255 - в тёмных областях, где гамма-кодирование усиливает ошибку.
+// При radius < MIN_BOX_BLUR_RADIUS ширины округляются до 1-3 пикселей (radius 1 - тождественный фильтр),
+// ошибка доходит до 60-75 уровней, поэтому там используется точное ядро
+constexpr int BOX_BLUR_PASSES = 3;
+constexpr int MIN_BOX_BLUR_RADIUS = 5;
+
+// Радиусы фильтров каскада: ширины - соседние нечётные числа, подобранные так, чтобы дисперсия совпала с sigma^2
+inline std::vector<int> GetBoxBlurRadii(const double sigma)
+{
+	constexpr int n = BOX_BLUR_PASSES;
+	const auto idealWidth = std::sqrt(12 * sigma * sigma / n + 1);
+	auto lowerWidth = static_cast<int>(std::floor(idealWidth));
+	if (lowerWidth % 2 == 0)
+	{
+		--lowerWidth;
+	}
+	const auto upperWidth = lowerWidth + 2;
+	const auto lowerNum = std::lround((12 * sigma * sigma - n * lowerWidth * lowerWidth - 4 * n * lowerWidth - 3 * n) / (-4.0 * lowerWidth - 4));
+
+	std::vector<int> radii;
+	for (int i = 0; i < n; ++i)
+	{
+		radii.push_back(((i < lowerNum ? lowerWidth : upperWidth) - 1) / 2);
+	}
+	return radii;
+}
+
+// Один проход равномерного фильтра по строке, края повторяются. padded - рабочий буфер, переиспользуется между вызовами.
+// src и dst могут совпадать
+inline void BoxBlurRow(const float* src, float* dst, const int width, const int radius, std::vector<float>& padded)
+{
+	padded.resize(width + 2 * radius);
+	std::fill(padded.begin(), padded.begin() + radius, src[0]);
+	std::copy(src, src + width, padded.begin() + radius);
+	std::fill(padded.begin() + radius + width, padded.end(), src[width - 1]);
+
+	// сумма в double, чтобы ошибка округления не копилась вдоль длинной строки
+	const auto scale = 1.0 / (2 * radius + 1);
+	double sum = 0;
+	for (int i = 0; i < 2 * radius + 1; ++i)
+	{
+		sum += padded[i];
+	}
+	dst[0] = static_cast<float>(sum * scale);
+	for (int x = 1; x < width; ++x)
+	{
+		sum += padded[x + 2 * radius] - padded[x - 1];
+		dst[x] = static_cast<float>(sum * scale);
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Конвейер с фиксированной точкой: яркость - uint16_t, веса ядра - Q16 с суммой ровно 1 << 16.
+// Сумма 65535 * 65536 плюс округление помещается в uint32_t, поэтому переполнения нет при любом радиусе
+constexpr int FIXED_POINT_KERNEL_BITS = 16;
+
+inline std::vector<uint32_t> QuantizeKernel(std::vector<float> const& kernel)
+{
+	std::vector<uint32_t> result;
+	int64_t sum = 0;
+	for (const auto weight : kernel)
+	{
+		result.push_back(static_cast<uint32_t>(std::lround(weight * (1 << FIXED_POINT_KERNEL_BITS))));
+		sum += result.back();
+	}
+	// ошибку округления забирает центральный вес, чтобы плоская область не темнела и не светлела
+	result[result.size() / 2] += static_cast<uint32_t>((int64_t{ 1 } << FIXED_POINT_KERNEL_BITS) - sum);
+	return result;
+}
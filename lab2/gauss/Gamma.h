@@ -0,0 +1,130 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Переход между 8-битными значениями с гаммой 2.2 и линейной яркостью через таблицы, без pow на каждый канал.
+// T - тип линейного значения: float в [0, 1] или uint16_t в [0, 65535]
+template <typename T>
+class Gamma;
+
+template <>
+class Gamma<float>
+{
+public:
+	static float Decode(const unsigned char c)
+	{
+		return GetTables().decode[c];
+	}
+
+	// То же, что static_cast<unsigned char>(pow(c, 1 / 2.2) * 255), но без pow: таблица по c даёт результат
+	// для начала интервала ENCODE_BUCKETS, дальше он уточняется по порогам, начиная с которых результат не меньше i.
+	// Вне тёмного начала шкалы уточнение - одно-два сравнения
+	static unsigned char Encode(const float c)
+	{
+		auto const& tables = GetTables();
+		const auto scaled = c * ENCODE_BUCKETS;
+		int i = 0;
+		if (scaled >= ENCODE_BUCKETS)
+		{
+			i = 255;
+		}
+		else if (scaled > 0)
+		{
+			i = tables.bucketStart[static_cast<int>(scaled)];
+		}
+		while (i < 255 && c >= tables.thresholds[i + 1])
+		{
+			++i;
+		}
+		return static_cast<unsigned char>(i);
+	}
+
+private:
+	static constexpr int ENCODE_BUCKETS = 4096;
+
+	struct Tables
+	{
+		std::array<float, 256> decode;
+		std::array<float, 256> thresholds;
+		std::array<unsigned char, ENCODE_BUCKETS> bucketStart;
+	};
+
+	static unsigned char EncodeExact(const float c)
+	{
+		return static_cast<unsigned char>(std::pow(c, 1.0 / 2.2) * 255);
+	}
+
+	static Tables const& GetTables()
+	{
+		static const auto tables = [] {
+			Tables result{};
+			for (int i = 0; i < 256; ++i)
+			{
+				result.decode[i] = std::pow(static_cast<float>(i) / 255, 2.2);
+			}
+			// порог уточняется до соседнего float, чтобы совпасть с EncodeExact на границах
+			result.thresholds[0] = -std::numeric_limits<float>::infinity();
+			for (int i = 1; i < 256; ++i)
+			{
+				auto threshold = static_cast<float>(std::pow(i / 255.0, 2.2));
+				while (EncodeExact(threshold) < i)
+				{
+					threshold = std::nextafter(threshold, 2.0f);
+				}
+				while (threshold > 0 && EncodeExact(std::nextafter(threshold, 0.0f)) >= i)
+				{
+					threshold = std::nextafter(threshold, 0.0f);
+				}
+				result.thresholds[i] = threshold;
+			}
+			for (int bucket = 0; bucket < ENCODE_BUCKETS; ++bucket)
+			{
+				result.bucketStart[bucket] = EncodeExact(static_cast<float>(bucket) / ENCODE_BUCKETS);
+			}
+			return result;
+		}();
+		return tables;
+	}
+};
+
+template <>
+class Gamma<uint16_t>
+{
+public:
+	static uint16_t Decode(const unsigned char c)
+	{
+		return GetTables().decode[c];
+	}
+
+	static unsigned char Encode(const uint16_t c)
+	{
+		return GetTables().encode[c];
+	}
+
+private:
+	struct Tables
+	{
+		std::array<uint16_t, 256> decode;
+		std::array<unsigned char, 65536> encode;
+	};
+
+	static Tables const& GetTables()
+	{
+		static const auto tables = [] {
+			Tables result{};
+			for (int i = 0; i < 256; ++i)
+			{
+				result.decode[i] = static_cast<uint16_t>(std::lround(std::pow(i / 255.0, 2.2) * 65535));
+			}
+			for (int i = 0; i < 65536; ++i)
+			{
+				// с отбрасыванием дробной части, как Gamma<float>::Encode
+				result.encode[i] = static_cast<unsigned char>(std::pow(i / 65535.0, 1 / 2.2) * 255);
+			}
+			return result;
+		}();
+		return tables;
+	}
+};
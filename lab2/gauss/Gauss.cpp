@@ -1,51 +1,263 @@
 #include "Gauss.h"
+#include "BoxBlur.h"
+#include "FixedPointBlur.h"
 #include "GaussianKernel.h"
-#include "Parallel.h"
 #include "Pixels.h"
+#include "RowBlur.h"
 #include "../../lib/timer/Timer.h"
+#include "../parallel/ThreadPool.h"
+#include <algorithm>
 #include <cmath>
 #include <wx/wx.h>
 
-void ApplyHorizontalBlur(const Pixels& pixels, const std::vector<float>& kernel, const int radius, const int start, const int end, Pixels& result)
+// Строка каждого канала копируется в дополненный буфер: края повторяются в дополнении
+// вместо ограничения индекса на каждом отсчёте, а свёртка идёт векторно по 8 пикселей
+void ApplyHorizontalBlur(const Pixels& pixels, const std::vector<float>& kernel, const int radius, const int startRow, const int endRow, Pixels& result)
 {
 	const auto width = pixels.GetWidth();
-	for (int i = start; i < end; i++)
+	std::vector<float> padded(width + 2 * radius);
+
+	for (int y = startRow; y < endRow; ++y)
 	{
-		const int x = i % width;
-		const int y = i / width;
-		Pixel newPixel{};
-		for (int kx = -radius; kx <= radius; ++kx)
+		for (int c = 0; c < Pixels::CHANNELS; ++c)
 		{
-			const int px = std::min(std::max(x + kx, 0), width - 1);
-			const float weight = kernel[kx + radius];
-			newPixel += pixels.Get(px, y) * weight;
+			const auto* row = pixels.GetRow(c, y);
+			std::fill(padded.begin(), padded.begin() + radius, row[0]);
+			std::copy(row, row + width, padded.begin() + radius);
+			std::fill(padded.begin() + radius + width, padded.end(), row[width - 1]);
+			BlurRow(padded.data(), result.GetRow(c, y), width, kernel);
 		}
-		result.Set(x, y, newPixel);
 	}
 }
 
-wxImage BlurParallel(wxImage const& img, const int radius, const int threadsNum)
+void ApplyHorizontalBoxBlur(const Pixels& pixels, std::vector<int> const& radii, const int startRow, const int endRow, Pixels& result)
 {
-	const auto sigma = radius / 3.29;
-	const auto kernel = GenerateGaussianKernel(radius, sigma);
+	const auto width = pixels.GetWidth();
+	std::vector<float> padded;
+	for (int y = startRow; y < endRow; ++y)
+	{
+		for (int c = 0; c < Pixels::CHANNELS; ++c)
+		{
+			const auto* src = pixels.GetRow(c, y);
+			for (const auto radius : radii)
+			{
+				BoxBlurRow(src, result.GetRow(c, y), width, radius, padded);
+				src = result.GetRow(c, y);
+			}
+		}
+	}
+}
+
+void ApplyHorizontalBlur16(const Pixels16& pixels, std::vector<uint32_t> const& kernel, const int radius, const int startRow, const int endRow, Pixels16& result)
+{
+	const auto width = pixels.GetWidth();
+	std::vector<uint16_t> padded(width + 2 * radius);
 
-	const Pixels pixels(img);
+	for (int y = startRow; y < endRow; ++y)
+	{
+		for (int c = 0; c < Pixels16::CHANNELS; ++c)
+		{
+			const auto* row = pixels.GetRow(c, y);
+			std::fill(padded.begin(), padded.begin() + radius, row[0]);
+			std::copy(row, row + width, padded.begin() + radius);
+			std::fill(padded.begin() + radius + width, padded.end(), row[width - 1]);
+			BlurRow16(padded.data(), result.GetRow(c, y), width, kernel);
+		}
+	}
+}
+
+// Оба прохода горизонтальные: между ними изображение транспонируется, и вертикальный проход
+// тоже читает память подряд. rowPass(src, startRow, endRow, result) обрабатывает строки [startRow, endRow)
+template <typename Image, typename RowPass>
+Image BlurTwoPass(Image const& pixels, RowPass const& rowPass, ThreadPool& pool)
+{
 	const int width = pixels.GetWidth();
 	const int height = pixels.GetHeight();
 
-	Pixels horizontalBlur(width, height);
-	ComputeParallel(width * height, threadsNum, [&](const size_t start, const size_t end) {
-		ApplyHorizontalBlur(pixels, kernel, radius, start, end, horizontalBlur);
+	Image horizontalBlur(width, height);
+	pool.ParallelFor(height, [&](const size_t start, const size_t end) {
+		rowPass(pixels, start, end, horizontalBlur);
+	});
+
+	Image transposed(height, width);
+	horizontalBlur.Transpose(transposed, pool);
+	Image verticalBlur(height, width);
+	pool.ParallelFor(width, [&](const size_t start, const size_t end) {
+		rowPass(transposed, start, end, verticalBlur);
 	});
-	Pixels result(width, height);
-	horizontalBlur.Transpose();
-	result.Transpose();
-	ComputeParallel(width * height, threadsNum, [&](const size_t start, const size_t end) {
-		ApplyHorizontalBlur(horizontalBlur, kernel, radius, start, end, result);
+
+	Image result(width, height);
+	verticalBlur.Transpose(result, pool);
+	return result;
+}
+
+constexpr int MIN_BLUR_TILE_SIZE = 128;
+constexpr int MAX_BLUR_TILE_SIZE = 512;
+
+// Блок растёт с радиусом, чтобы ореол из radius строк с каждой стороны занимал не больше половины блока
+int GetBlurTileSize(const int radius)
+{
+	return std::clamp((4 * radius + 63) / 64 * 64, MIN_BLUR_TILE_SIZE, MAX_BLUR_TILE_SIZE);
+}
+
+// Когда блок упирается в предел, а ореол всё ещё больше половины блока, повторный горизонтальный проход
+// по ореолу обходится дороже, чем лишний проход по памяти в TwoPass
+bool IsTiledBlurEffective(const int radius)
+{
+	return 4 * radius <= MAX_BLUR_TILE_SIZE;
+}
+
+// Горизонтальный проход считается для строк блока и radius строк над и под ним в буфер размером с блок,
+// затем вертикальный проход читает этот буфер, пока он в L2. Края изображения повторяются
+void BlurTile(Pixels const& pixels, std::vector<float> const& kernel, const int radius, const int tileSize, const int tileX, const int tileY, Pixels& result)
+{
+	const int width = pixels.GetWidth();
+	const int height = pixels.GetHeight();
+	const int x0 = tileX * tileSize;
+	const int tileWidth = std::min(tileSize, width - x0);
+	const int y0 = tileY * tileSize;
+	const int y1 = std::min(y0 + tileSize, height);
+	const int haloY0 = std::max(y0 - radius, 0);
+	const int haloY1 = std::min(y1 + radius, height);
+
+	// буферы свои у каждого потока и переживают блоки и вызовы; перед чтением они всегда записаны, поэтому только растут
+	thread_local std::vector<float> padded;
+	thread_local std::vector<float> intermediate;
+	thread_local std::vector<const float*> rows;
+	const auto grow = [](auto& buffer, const size_t size) {
+		if (buffer.size() < size)
+		{
+			buffer.resize(size);
+		}
+	};
+	grow(padded, static_cast<size_t>(tileWidth) + 2 * radius);
+	grow(intermediate, static_cast<size_t>(haloY1 - haloY0) * tileWidth);
+	grow(rows, kernel.size());
+
+	for (int c = 0; c < Pixels::CHANNELS; ++c)
+	{
+		for (int y = haloY0; y < haloY1; ++y)
+		{
+			const auto* row = pixels.GetRow(c, y);
+			for (int i = 0; i < tileWidth + 2 * radius; ++i)
+			{
+				padded[i] = row[std::clamp(x0 - radius + i, 0, width - 1)];
+			}
+			BlurRow(padded.data(), intermediate.data() + static_cast<size_t>(y - haloY0) * tileWidth, tileWidth, kernel);
+		}
+
+		for (int y = y0; y < y1; ++y)
+		{
+			for (int k = 0; k < static_cast<int>(kernel.size()); ++k)
+			{
+				rows[k] = intermediate.data() + static_cast<size_t>(std::clamp(y - radius + k, 0, height - 1) - haloY0) * tileWidth;
+			}
+			BlurColumns(rows.data(), result.GetRow(c, y) + x0, tileWidth, kernel);
+		}
+	}
+}
+
+Pixels BlurTiled(Pixels const& pixels, std::vector<float> const& kernel, const int radius, ThreadPool& pool)
+{
+	// блоков должно хватить на все потоки, даже если ради этого ореол станет больше половины блока
+	int tileSize = GetBlurTileSize(radius);
+	const auto getTilesNum = [&](const int size) {
+		return ((pixels.GetWidth() + size - 1) / size) * ((pixels.GetHeight() + size - 1) / size);
+	};
+	while (tileSize > MIN_BLUR_TILE_SIZE && getTilesNum(tileSize) < 2 * pool.GetThreadsNum())
+	{
+		tileSize /= 2;
+	}
+	const int tilesX = (pixels.GetWidth() + tileSize - 1) / tileSize;
+	const int tilesY = (pixels.GetHeight() + tileSize - 1) / tileSize;
+
+	Pixels result(pixels.GetWidth(), pixels.GetHeight());
+	pool.ParallelFor(tilesX * tilesY, 1, [&](const size_t start, const size_t end) {
+		for (auto tile = start; tile < end; ++tile)
+		{
+			BlurTile(pixels, kernel, radius, tileSize, static_cast<int>(tile % tilesX), static_cast<int>(tile / tilesX), result);
+		}
 	});
-	result.Transpose();
+	return result;
+}
 
-	return result.GetImage();
+BlurMode ParseBlurMode(std::string const& name)
+{
+	if (name == "two-pass")
+	{
+		return BlurMode::TwoPass;
+	}
+	if (name == "tiled")
+	{
+		return BlurMode::Tiled;
+	}
+	if (name == "box")
+	{
+		return BlurMode::Box;
+	}
+	if (name == "fixed16")
+	{
+		return BlurMode::Fixed16;
+	}
+	throw std::invalid_argument("Unknown blur mode: " + name);
+}
+
+// Переводит img в Image, размывает blur(pixels) и переводит обратно, засекая время каждого этапа
+template <typename Image, typename Blur>
+wxImage BlurInStages(wxImage const& img, ThreadPool& pool, BlurTimings* timings, Blur const& blur)
+{
+	using Clock = std::chrono::steady_clock;
+	const auto start = Clock::now();
+	const Image pixels(img, pool);
+	const auto loaded = Clock::now();
+	const auto blurred = blur(pixels);
+	const auto blurEnd = Clock::now();
+	auto result = blurred.GetImage(pool);
+
+	if (timings)
+	{
+		timings->load = loaded - start;
+		timings->blur = blurEnd - loaded;
+		timings->store = Clock::now() - blurEnd;
+	}
+	return result;
+}
+
+wxImage BlurParallel(wxImage const& img, const int radius, ThreadPool& pool, const BlurMode mode, BlurTimings* timings)
+{
+	const auto sigma = radius / 3.29;
+	if (mode == BlurMode::Fixed16)
+	{
+		const auto kernel = QuantizeKernel(GenerateGaussianKernel(radius, sigma));
+		return BlurInStages<Pixels16>(img, pool, timings, [&](Pixels16 const& pixels) {
+			return BlurTwoPass(pixels, [&](const Pixels16& src, const int startRow, const int endRow, Pixels16& result) {
+				ApplyHorizontalBlur16(src, kernel, radius, startRow, endRow, result);
+			}, pool);
+		});
+	}
+
+	if (mode == BlurMode::Box && radius >= MIN_BOX_BLUR_RADIUS)
+	{
+		const auto radii = GetBoxBlurRadii(sigma);
+		return BlurInStages<Pixels>(img, pool, timings, [&](Pixels const& pixels) {
+			return BlurTwoPass(pixels, [&](const Pixels& src, const int startRow, const int endRow, Pixels& result) {
+				ApplyHorizontalBoxBlur(src, radii, startRow, endRow, result);
+			}, pool);
+		});
+	}
+
+	const auto kernel = GenerateGaussianKernel(radius, sigma);
+	if (mode == BlurMode::TwoPass || !IsTiledBlurEffective(radius))
+	{
+		return BlurInStages<Pixels>(img, pool, timings, [&](Pixels const& pixels) {
+			return BlurTwoPass(pixels, [&](const Pixels& src, const int startRow, const int endRow, Pixels& result) {
+				ApplyHorizontalBlur(src, kernel, radius, startRow, endRow, result);
+			}, pool);
+		});
+	}
+	return BlurInStages<Pixels>(img, pool, timings, [&](Pixels const& pixels) {
+		return BlurTiled(pixels, kernel, radius, pool);
+	});
 }
 
 void GaussBlur(Args const& args)
@@ -64,13 +276,16 @@ void GaussBlur(Args const& args)
 		throw std::runtime_error("Image loading failed.");
 	}
 
+	std::cout << "Row blur instruction set: " << GetRowBlurInstructionSet() << std::endl;
+	ThreadPool pool(args.threadsNum);
+	BlurTimings timings;
 	wxImage result;
-	for (int i = 1; i <= 20; ++i)
-	{
-		MeasureTime(std::cout, "Gaussian blur with " + std::to_string(i) + " threads", [&] {
-			result = BlurParallel(img, args.radius, i);
-		});
-	}
+	MeasureTime(std::cout, "Gaussian blur with " + std::to_string(args.threadsNum) + " threads", [&] {
+		result = BlurParallel(img, args.radius, pool, args.mode, &timings);
+	});
+	std::cout << "  from wxImage " << std::chrono::duration_cast<std::chrono::milliseconds>(timings.load).count() << "ms"
+			  << ", blur " << std::chrono::duration_cast<std::chrono::milliseconds>(timings.blur).count() << "ms"
+			  << ", to wxImage " << std::chrono::duration_cast<std::chrono::milliseconds>(timings.store).count() << "ms" << std::endl;
 
 	if (!result.SaveFile(args.outputFileName, wxBITMAP_TYPE_JPEG))
 	{
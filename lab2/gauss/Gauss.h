@@ -1,14 +1,41 @@
 #pragma once
+#include "../parallel/ThreadPool.h"
+#include <chrono>
 #include <string>
 #include <wx/wx.h>
 
+enum class BlurMode
+{
+	// два полных прохода по строкам с транспонированием между ними
+	TwoPass,
+	// оба прохода по очереди на каждом блоке, промежуточный результат блока остаётся в кэше.
+	// Блок растёт с радиусом, при очень большом радиусе размытие идёт как TwoPass
+	Tiled,
+	// каскад из трёх скользящих средних: время не зависит от радиуса, результат приближённый (см. BoxBlur.h).
+	// При радиусе меньше MIN_BOX_BLUR_RADIUS размывает точным ядром
+	Box,
+	// точное ядро в фиксированной точке: яркость uint16_t, веса Q16 - вдвое меньше памяти, чем float
+	Fixed16,
+};
+
+BlurMode ParseBlurMode(std::string const& name);
+
+// Время этапов BlurParallel: перевод из wxImage, размытие и перевод обратно
+struct BlurTimings
+{
+	std::chrono::nanoseconds load{};
+	std::chrono::nanoseconds blur{};
+	std::chrono::nanoseconds store{};
+};
+
 struct Args
 {
 	std::string inputFileName;
 	std::string outputFileName;
 	int radius;
 	int threadsNum;
+	BlurMode mode = BlurMode::Tiled;
 };
 
 void GaussBlur(Args const& args);
-wxImage BlurParallel(wxImage const& img, int radius, int threadsNum);
\ No newline at end of file
+wxImage BlurParallel(wxImage const& img, int radius, ThreadPool& pool, BlurMode mode = BlurMode::Tiled, BlurTimings* timings = nullptr);
\ No newline at end of file
@@ -1,107 +1,176 @@
 #pragma once
+#include "Gamma.h"
 #include "Pixel.h"
+#include "../parallel/ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstdint>
 #include <vector>
 #include <wx/image.h>
 
-// транспонировать по настоящему
-class Pixels
+// Изображение из трёх плоскостей (R, G, B) линейной яркости: строка канала лежит в памяти подряд.
+// T - float или uint16_t для конвейера с фиксированной точкой
+template <typename T>
+class BasicPixels
 {
 public:
-	explicit Pixels(wxImage const& img)
-		: m_width(img.GetWidth())
-		  , m_height(img.GetHeight())
+	static constexpr int CHANNELS = 3;
+	static constexpr int TRANSPOSE_TILE = 32;
+
+	// Перевод из wxImage и обратно работает прямо с буфером RGB из GetData(), строки делятся между потоками пула
+	BasicPixels(wxImage const& img, ThreadPool& pool)
+		: BasicPixels(img.GetWidth(), img.GetHeight())
 	{
-		InitPixels(img);
+		InitPixels(img, pool);
 	}
 
-	Pixels(const int width, const int height)
+	BasicPixels(const int width, const int height)
 		: m_width(width)
 		  , m_height(height)
 	{
-		m_data.resize(width * height);
+		for (auto& plane : m_planes)
+		{
+			plane.resize(static_cast<size_t>(width) * height);
+		}
 	}
 
 	void Set(const int x, const int y, Pixel const& pixel)
+		requires std::same_as<T, float>
 	{
-		if (m_transposed)
-		{
-			m_data[x * m_width + y] = pixel;
-		}
-		else
-		{
-			m_data[y * m_width + x] = pixel;
-		}
+		const auto i = Index(x, y);
+		m_planes[0][i] = pixel.r;
+		m_planes[1][i] = pixel.g;
+		m_planes[2][i] = pixel.b;
 	}
 
 	[[nodiscard]] Pixel Get(const int x, const int y) const
+		requires std::same_as<T, float>
 	{
-		if (m_transposed)
-		{
-			return m_data[x * m_width + y];
-		}
-		return m_data[y * m_width + x];
+		const auto i = Index(x, y);
+		return { m_planes[0][i], m_planes[1][i], m_planes[2][i] };
 	}
 
-	wxImage GetImage() const
+	[[nodiscard]] T* GetRow(const int channel, const int y)
 	{
-		wxImage img(m_width, m_height);
-		for (int i = 0; i < m_width * m_height; i++)
-		{
-			const auto [r, g, b] = m_data[i];
-			img.SetRGB(i % m_width, i / m_width,
-				DenormalizeColor(r),
-				DenormalizeColor(g),
-				DenormalizeColor(b));
-		}
+		return m_planes[channel].data() + Index(0, y);
+	}
+
+	[[nodiscard]] const T* GetRow(const int channel, const int y) const
+	{
+		return m_planes[channel].data() + Index(0, y);
+	}
+
+	wxImage GetImage(ThreadPool& pool) const
+	{
+		wxImage img(m_width, m_height, false);
+		auto* data = img.GetData();
+		pool.ParallelFor(m_height, [&](const size_t start, const size_t end) {
+			for (auto y = static_cast<int>(start); y < static_cast<int>(end); ++y)
+			{
+				const auto* r = GetRow(0, y);
+				const auto* g = GetRow(1, y);
+				const auto* b = GetRow(2, y);
+				auto* dst = data + Index(0, y) * CHANNELS;
+				for (int x = 0; x < m_width; ++x)
+				{
+					dst[CHANNELS * x] = Gamma<T>::Encode(r[x]);
+					dst[CHANNELS * x + 1] = Gamma<T>::Encode(g[x]);
+					dst[CHANNELS * x + 2] = Gamma<T>::Encode(b[x]);
+				}
+			}
+		});
 
 		return img;
 	}
 
 	[[nodiscard]] int GetWidth() const
 	{
-		return m_transposed ? m_height : m_width;
+		return m_width;
 	}
 
 	[[nodiscard]] int GetHeight() const
 	{
-		return m_transposed ? m_width : m_height;
+		return m_height;
 	}
 
-	void Transpose()
+	// Записывает в result транспонированное изображение (result - height x width).
+	// Копирование идёт блоками TRANSPOSE_TILE x TRANSPOSE_TILE, чтобы и чтение, и запись попадали в кэш,
+	// полосы блоков делятся между потоками пула
+	void Transpose(BasicPixels& result, ThreadPool& pool) const
 	{
-		m_transposed = !m_transposed;
+		result.Resize(m_height, m_width);
+		const auto tileRows = (m_height + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE;
+		pool.ParallelFor(tileRows, 1, [&](const size_t start, const size_t end) {
+			for (auto tileRow = static_cast<int>(start); tileRow < static_cast<int>(end); ++tileRow)
+			{
+				const auto y0 = tileRow * TRANSPOSE_TILE;
+				const auto y1 = std::min(y0 + TRANSPOSE_TILE, m_height);
+				for (int x0 = 0; x0 < m_width; x0 += TRANSPOSE_TILE)
+				{
+					const auto x1 = std::min(x0 + TRANSPOSE_TILE, m_width);
+					for (int c = 0; c < CHANNELS; ++c)
+					{
+						TransposeTile(m_planes[c].data(), m_width, result.m_planes[c].data(), m_height, x0, x1, y0, y1);
+					}
+				}
+			}
+		});
 	}
 
 private:
-	void InitPixels(wxImage const& img)
+	[[nodiscard]] size_t Index(const int x, const int y) const
 	{
-		m_data.reserve(m_width * m_height);
-		for (int y = 0; y < m_height; y++)
+		return static_cast<size_t>(y) * m_width + x;
+	}
+
+	void Resize(const int width, const int height)
+	{
+		m_width = width;
+		m_height = height;
+		for (auto& plane : m_planes)
 		{
-			for (int x = 0; x < m_width; x++)
-			{
-				m_data.emplace_back(Pixel{
-					NormalizeColor(img.GetRed(x, y)),
-					NormalizeColor(img.GetGreen(x, y)),
-					NormalizeColor(img.GetBlue(x, y)),
-				});
-			}
+			plane.resize(static_cast<size_t>(width) * height);
 		}
 	}
 
-	static float NormalizeColor(const unsigned char c)
+	static void TransposeTile(const T* src, const int srcStride, T* dst, const int dstStride, const int x0, const int x1, const int y0, const int y1)
 	{
-		return std::pow(static_cast<float>(c) / 255, 2.2);
+		for (int x = x0; x < x1; ++x)
+		{
+			auto* dstRow = dst + static_cast<size_t>(x) * dstStride;
+			for (int y = y0; y < y1; ++y)
+			{
+				dstRow[y] = src[static_cast<size_t>(y) * srcStride + x];
+			}
+		}
 	}
 
-	static unsigned char DenormalizeColor(const float c)
+	void InitPixels(wxImage const& img, ThreadPool& pool)
 	{
-		return static_cast<unsigned char>(std::pow(c, 1.0 / 2.2) * 255);
+		const auto* data = img.GetData();
+		pool.ParallelFor(m_height, [&](const size_t start, const size_t end) {
+			for (auto y = static_cast<int>(start); y < static_cast<int>(end); ++y)
+			{
+				auto* r = GetRow(0, y);
+				auto* g = GetRow(1, y);
+				auto* b = GetRow(2, y);
+				const auto* src = data + Index(0, y) * CHANNELS;
+				for (int x = 0; x < m_width; ++x)
+				{
+					r[x] = Gamma<T>::Decode(src[CHANNELS * x]);
+					g[x] = Gamma<T>::Decode(src[CHANNELS * x + 1]);
+					b[x] = Gamma<T>::Decode(src[CHANNELS * x + 2]);
+				}
+			}
+		});
 	}
 
 private:
 	int m_width;
 	int m_height;
-	std::vector<Pixel> m_data;
-	bool m_transposed = false;
+	std::array<std::vector<T>, CHANNELS> m_planes;
 };
+
+using Pixels = BasicPixels<float>;
+using Pixels16 = BasicPixels<uint16_t>;
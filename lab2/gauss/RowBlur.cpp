@@ -0,0 +1,260 @@
+#include "RowBlur.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GAUSS_WITH_X86_SIMD
+#endif
+
+namespace
+{
+using BlurRowFunction = void (*)(const float* src, float* dst, int width, const float* kernel, int size);
+using BlurColumnsFunction = void (*)(const float* const* rows, float* dst, int width, const float* kernel, int size);
+using BlurRow16Function = void (*)(const uint16_t* src, uint16_t* dst, int width, const uint32_t* kernel, int size);
+
+// 65535 * (1 << 16) плюс половина для округления помещается в uint32_t
+constexpr uint32_t ROUNDING = 1u << 15;
+constexpr int FIXED_SHIFT = 16;
+
+void BlurRowTail(const float* src, float* dst, int x, const int width, const float* kernel, const int size)
+{
+	for (; x < width; ++x)
+	{
+		float sum = 0;
+		for (int k = 0; k < size; ++k)
+		{
+			sum += src[x + k] * kernel[k];
+		}
+		dst[x] = sum;
+	}
+}
+
+void BlurRowScalar(const float* src, float* dst, const int width, const float* kernel, const int size)
+{
+	BlurRowTail(src, dst, 0, width, kernel, size);
+}
+
+void BlurColumnsTail(const float* const* rows, float* dst, int x, const int width, const float* kernel, const int size)
+{
+	for (; x < width; ++x)
+	{
+		float sum = 0;
+		for (int k = 0; k < size; ++k)
+		{
+			sum += rows[k][x] * kernel[k];
+		}
+		dst[x] = sum;
+	}
+}
+
+void BlurColumnsScalar(const float* const* rows, float* dst, const int width, const float* kernel, const int size)
+{
+	BlurColumnsTail(rows, dst, 0, width, kernel, size);
+}
+
+void BlurRow16Tail(const uint16_t* src, uint16_t* dst, int x, const int width, const uint32_t* kernel, const int size)
+{
+	for (; x < width; ++x)
+	{
+		uint32_t sum = ROUNDING;
+		for (int k = 0; k < size; ++k)
+		{
+			sum += src[x + k] * kernel[k];
+		}
+		dst[x] = static_cast<uint16_t>(sum >> FIXED_SHIFT);
+	}
+}
+
+void BlurRow16Scalar(const uint16_t* src, uint16_t* dst, const int width, const uint32_t* kernel, const int size)
+{
+	BlurRow16Tail(src, dst, 0, width, kernel, size);
+}
+
+#ifdef GAUSS_WITH_X86_SIMD
+__attribute__((target("sse4.1"))) void BlurRowSse(const float* src, float* dst, const int width, const float* kernel, const int size)
+{
+	int x = 0;
+	// две группы по 4 пикселя - 8 за итерацию, вес загружается один раз на обе
+	for (; x + 8 <= width; x += 8)
+	{
+		auto sum0 = _mm_setzero_ps();
+		auto sum1 = _mm_setzero_ps();
+		for (int k = 0; k < size; ++k)
+		{
+			const auto weight = _mm_set1_ps(kernel[k]);
+			sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(src + x + k), weight));
+			sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(src + x + k + 4), weight));
+		}
+		_mm_storeu_ps(dst + x, sum0);
+		_mm_storeu_ps(dst + x + 4, sum1);
+	}
+	BlurRowTail(src, dst, x, width, kernel, size);
+}
+
+__attribute__((target("sse4.1"))) void BlurColumnsSse(const float* const* rows, float* dst, const int width, const float* kernel, const int size)
+{
+	int x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		auto sum0 = _mm_setzero_ps();
+		auto sum1 = _mm_setzero_ps();
+		for (int k = 0; k < size; ++k)
+		{
+			const auto weight = _mm_set1_ps(kernel[k]);
+			sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(rows[k] + x), weight));
+			sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(rows[k] + x + 4), weight));
+		}
+		_mm_storeu_ps(dst + x, sum0);
+		_mm_storeu_ps(dst + x + 4, sum1);
+	}
+	BlurColumnsTail(rows, dst, x, width, kernel, size);
+}
+
+__attribute__((target("sse4.1"))) void BlurRow16Sse(const uint16_t* src, uint16_t* dst, const int width, const uint32_t* kernel, const int size)
+{
+	int x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		auto sum0 = _mm_set1_epi32(ROUNDING);
+		auto sum1 = _mm_set1_epi32(ROUNDING);
+		for (int k = 0; k < size; ++k)
+		{
+			const auto weight = _mm_set1_epi32(static_cast<int>(kernel[k]));
+			const auto values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x + k));
+			sum0 = _mm_add_epi32(sum0, _mm_mullo_epi32(_mm_cvtepu16_epi32(values), weight));
+			sum1 = _mm_add_epi32(sum1, _mm_mullo_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(values, 8)), weight));
+		}
+		const auto packed = _mm_packus_epi32(_mm_srli_epi32(sum0, FIXED_SHIFT), _mm_srli_epi32(sum1, FIXED_SHIFT));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), packed);
+	}
+	BlurRow16Tail(src, dst, x, width, kernel, size);
+}
+
+__attribute__((target("avx2,fma"))) void BlurRowAvx2(const float* src, float* dst, const int width, const float* kernel, const int size)
+{
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+		auto sum0 = _mm256_setzero_ps();
+		auto sum1 = _mm256_setzero_ps();
+		for (int k = 0; k < size; ++k)
+		{
+			const auto weight = _mm256_broadcast_ss(kernel + k);
+			sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(src + x + k), weight, sum0);
+			sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(src + x + k + 8), weight, sum1);
+		}
+		_mm256_storeu_ps(dst + x, sum0);
+		_mm256_storeu_ps(dst + x + 8, sum1);
+	}
+	for (; x + 8 <= width; x += 8)
+	{
+		auto sum = _mm256_setzero_ps();
+		for (int k = 0; k < size; ++k)
+		{
+			sum = _mm256_fmadd_ps(_mm256_loadu_ps(src + x + k), _mm256_broadcast_ss(kernel + k), sum);
+		}
+		_mm256_storeu_ps(dst + x, sum);
+	}
+	BlurRowTail(src, dst, x, width, kernel, size);
+}
+
+__attribute__((target("avx2,fma"))) void BlurColumnsAvx2(const float* const* rows, float* dst, const int width, const float* kernel, const int size)
+{
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+		auto sum0 = _mm256_setzero_ps();
+		auto sum1 = _mm256_setzero_ps();
+		for (int k = 0; k < size; ++k)
+		{
+			const auto weight = _mm256_broadcast_ss(kernel + k);
+			sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(rows[k] + x), weight, sum0);
+			sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(rows[k] + x + 8), weight, sum1);
+		}
+		_mm256_storeu_ps(dst + x, sum0);
+		_mm256_storeu_ps(dst + x + 8, sum1);
+	}
+	for (; x + 8 <= width; x += 8)
+	{
+		auto sum = _mm256_setzero_ps();
+		for (int k = 0; k < size; ++k)
+		{
+			sum = _mm256_fmadd_ps(_mm256_loadu_ps(rows[k] + x), _mm256_broadcast_ss(kernel + k), sum);
+		}
+		_mm256_storeu_ps(dst + x, sum);
+	}
+	BlurColumnsTail(rows, dst, x, width, kernel, size);
+}
+
+__attribute__((target("avx2,fma"))) void BlurRow16Avx2(const uint16_t* src, uint16_t* dst, const int width, const uint32_t* kernel, const int size)
+{
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+		auto sum0 = _mm256_set1_epi32(ROUNDING);
+		auto sum1 = _mm256_set1_epi32(ROUNDING);
+		for (int k = 0; k < size; ++k)
+		{
+			const auto weight = _mm256_set1_epi32(static_cast<int>(kernel[k]));
+			const auto values0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x + k));
+			const auto values1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x + k + 8));
+			sum0 = _mm256_add_epi32(sum0, _mm256_mullo_epi32(_mm256_cvtepu16_epi32(values0), weight));
+			sum1 = _mm256_add_epi32(sum1, _mm256_mullo_epi32(_mm256_cvtepu16_epi32(values1), weight));
+		}
+		// packus чередует 128-битные половины, permute возвращает порядок пикселей
+		const auto packed = _mm256_packus_epi32(_mm256_srli_epi32(sum0, FIXED_SHIFT), _mm256_srli_epi32(sum1, FIXED_SHIFT));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_permute4x64_epi64(packed, 0xD8));
+	}
+	BlurRow16Tail(src, dst, x, width, kernel, size);
+}
+#endif
+
+struct RowBlurImplementation
+{
+	BlurRowFunction row;
+	BlurColumnsFunction columns;
+	BlurRow16Function row16;
+	const char* instructionSet;
+};
+
+RowBlurImplementation SelectRowBlur()
+{
+#ifdef GAUSS_WITH_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		return { BlurRowAvx2, BlurColumnsAvx2, BlurRow16Avx2, "avx2" };
+	}
+	if (__builtin_cpu_supports("sse4.1"))
+	{
+		return { BlurRowSse, BlurColumnsSse, BlurRow16Sse, "sse4.1" };
+	}
+#endif
+	return { BlurRowScalar, BlurColumnsScalar, BlurRow16Scalar, "scalar" };
+}
+
+RowBlurImplementation const& GetRowBlur()
+{
+	static const auto implementation = SelectRowBlur();
+	return implementation;
+}
+} // namespace
+
+void BlurRow(const float* src, float* dst, const int width, std::span<const float> kernel)
+{
+	GetRowBlur().row(src, dst, width, kernel.data(), static_cast<int>(kernel.size()));
+}
+
+void BlurColumns(const float* const* rows, float* dst, const int width, std::span<const float> kernel)
+{
+	GetRowBlur().columns(rows, dst, width, kernel.data(), static_cast<int>(kernel.size()));
+}
+
+void BlurRow16(const uint16_t* src, uint16_t* dst, const int width, std::span<const uint32_t> kernel)
+{
+	GetRowBlur().row16(src, dst, width, kernel.data(), static_cast<int>(kernel.size()));
+}
+
+const char* GetRowBlurInstructionSet()
+{
+	return GetRowBlur().instructionSet;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+// Свёртка одной строки одного канала с ядром из 2 * radius + 1 весов.
+// src дополнена radius значениями слева и справа, поэтому индексы не ограничиваются на каждом отсчёте
+void BlurRow(const float* src, float* dst, int width, std::span<const float> kernel);
+
+// Вертикальная свёртка: dst[x] = sum(kernel[k] * rows[k][x]), rows - 2 * radius + 1 указателей на строки.
+// Края изображения задаются повтором указателей, вектор идёт вдоль строки
+void BlurColumns(const float* const* rows, float* dst, int width, std::span<const float> kernel);
+
+// То же для конвейера с фиксированной точкой: веса Q16 с суммой 1 << 16, результат округляется
+void BlurRow16(const uint16_t* src, uint16_t* dst, int width, std::span<const uint32_t> kernel);
+
+// Набор инструкций, выбранный для свёрток при запуске
+const char* GetRowBlurInstructionSet();
@@ -36,12 +36,13 @@ private:
 
 		const wxImage blurredImage = radius == 0
 			? m_originalImage
-			: BlurParallel(m_originalImage, radius, 20);
+			: BlurParallel(m_originalImage, radius, m_pool);
 		m_bitmap->SetBitmap(wxBitmap(blurredImage));
 		Refresh();
 	}
 
 private:
+	ThreadPool m_pool{ 20 };
 	wxImage m_originalImage;
 	wxStaticBitmap* m_bitmap;
 	wxSlider* m_slider;
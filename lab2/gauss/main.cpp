@@ -1,22 +1,50 @@
+#include "BatchBlur.h"
 #include "Gauss.h"
 #include <iostream>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <variant>
 
-Args ParseCommandLine(int argc, char* argv[])
+using ProgramMode = std::variant<Args, BatchArgs>;
+
+// --batch <входной каталог> <выходной каталог> <радиус> <потоки декодирования> <потоки размытия> <потоки кодирования> [режим]
+BatchArgs ParseBatchCommandLine(int argc, char* argv[])
 {
-	if (argc != 5)
+	if (argc != 8 && argc != 9)
 	{
 		throw std::invalid_argument("Wrong number of arguments");
 	}
 
-	Args args;
 	return {
+		.inputDir = argv[2],
+		.outputDir = argv[3],
+		.radius = std::stoi(argv[4]),
+		.decodeThreads = std::stoi(argv[5]),
+		.blurThreads = std::stoi(argv[6]),
+		.encodeThreads = std::stoi(argv[7]),
+		.mode = argc == 9 ? ParseBlurMode(argv[8]) : BlurMode::Tiled,
+	};
+}
+
+ProgramMode ParseCommandLine(int argc, char* argv[])
+{
+	if (argc > 1 && std::string(argv[1]) == "--batch")
+	{
+		return ParseBatchCommandLine(argc, argv);
+	}
+	if (argc != 5 && argc != 6)
+	{
+		throw std::invalid_argument("Wrong number of arguments");
+	}
+
+	return Args{
 		.inputFileName = argv[1],
 		.outputFileName = argv[2],
 		.radius = std::stoi(argv[3]),
 		.threadsNum = std::stoi(argv[4]),
+		// необязательный режим: two-pass, tiled, box или fixed16
+		.mode = argc == 6 ? ParseBlurMode(argv[5]) : BlurMode::Tiled,
 	};
 }
 
@@ -24,8 +52,15 @@ int main(const int argc, char* argv[])
 {
 	try
 	{
-		const Args args = ParseCommandLine(argc, argv);
-		GaussBlur(args);
+		const auto mode = ParseCommandLine(argc, argv);
+		if (const auto* batchArgs = std::get_if<BatchArgs>(&mode))
+		{
+			BlurBatch(*batchArgs);
+		}
+		else
+		{
+			GaussBlur(std::get<Args>(mode));
+		}
 	}
 	catch (const std::exception& e)
 	{
@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct BenchResult
+{
+	int width = 0;
+	int height = 0;
+	int radius = 0;
+	std::string mode;
+	int threads = 1;
+	// BlurParallel целиком и только размытие, без перевода из wxImage и обратно
+	std::vector<double> seconds{};
+	std::vector<double> blurSeconds{};
+	int maxError = 0;
+	double psnr = 0;
+	// заполняются в ComputeSpeedup относительно наименьшего числа потоков того же размера, радиуса и режима
+	double speedup = 1.0;
+	double efficiency = 1.0;
+
+	[[nodiscard]] static double GetMedian(std::vector<double> values)
+	{
+		std::ranges::sort(values);
+		const auto middle = values.size() / 2;
+		return values.size() % 2 != 0 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+	}
+
+	[[nodiscard]] double GetMedian() const
+	{
+		return GetMedian(seconds);
+	}
+
+	[[nodiscard]] double GetMegapixelsPerSecond() const
+	{
+		return static_cast<double>(width) * height / 1e6 / GetMedian();
+	}
+
+	[[nodiscard]] bool IsSameCase(BenchResult const& other) const
+	{
+		return width == other.width && height == other.height && radius == other.radius && mode == other.mode;
+	}
+};
+
+inline void ComputeSpeedup(std::vector<BenchResult>& results)
+{
+	for (auto& result : results)
+	{
+		const BenchResult* base = nullptr;
+		for (const auto& other : results)
+		{
+			if (other.IsSameCase(result) && (!base || other.threads < base->threads))
+			{
+				base = &other;
+			}
+		}
+		result.speedup = base->GetMedian() / result.GetMedian();
+		result.efficiency = result.speedup * base->threads / result.threads;
+	}
+}
+
+inline void PrintResults(std::ostream& output, std::vector<BenchResult> const& results)
+{
+	const auto flags = output.flags();
+	const auto precision = output.precision();
+	output << std::left << std::setw(11) << "size" << std::setw(9) << "mode" << std::right << std::setw(7) << "radius"
+		   << std::setw(8) << "threads" << std::setw(10) << "median ms" << std::setw(9) << "blur ms" << std::setw(8) << "Mpx/s"
+		   << std::setw(9) << "speedup" << std::setw(7) << "eff" << std::setw(8) << "maxerr" << std::setw(8) << "PSNR" << std::endl;
+	output << std::fixed;
+	for (const auto& result : results)
+	{
+		output << std::left << std::setw(11) << (std::to_string(result.width) + "x" + std::to_string(result.height))
+			   << std::setw(9) << result.mode << std::right << std::setw(7) << result.radius << std::setw(8) << result.threads
+			   << std::setprecision(1) << std::setw(10) << result.GetMedian() * 1000
+			   << std::setw(9) << BenchResult::GetMedian(result.blurSeconds) * 1000
+			   << std::setw(8) << result.GetMegapixelsPerSecond()
+			   << std::setprecision(2) << std::setw(9) << result.speedup << std::setw(7) << result.efficiency
+			   << std::setw(8) << result.maxError << std::setprecision(1) << std::setw(8) << result.psnr << std::endl;
+	}
+	output.flags(flags);
+	output.precision(precision);
+}
+
+inline void WriteCsv(std::string const& path, std::vector<BenchResult> const& results)
+{
+	std::ofstream output(path);
+	if (!output)
+	{
+		throw std::runtime_error("Can not open report file " + path);
+	}
+	output << std::setprecision(6);
+	output << "width,height,radius,mode,threads,repeats,median_s,blur_median_s,mpixels_per_s,speedup,efficiency,max_error,psnr_db\n";
+	for (const auto& result : results)
+	{
+		output << result.width << ',' << result.height << ',' << result.radius << ',' << result.mode << ',' << result.threads << ','
+			   << result.seconds.size() << ',' << result.GetMedian() << ',' << BenchResult::GetMedian(result.blurSeconds) << ','
+			   << result.GetMegapixelsPerSecond() << ',' << result.speedup << ',' << result.efficiency << ','
+			   << result.maxError << ',' << result.psnr << '\n';
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "../parallel/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <wx/image.h>
+
+// Эталон для проверки режимов: то же размытие целиком в double - точное ядро без округления весов,
+// края повторяются, гамма 2.2 через pow. Результат - 8-битный RGB, как в wxImage::GetData()
+inline std::vector<unsigned char> ReferenceBlur(wxImage const& img, const int radius, ThreadPool& pool)
+{
+	const int width = img.GetWidth();
+	const int height = img.GetHeight();
+	const auto sigma = radius / 3.29;
+	std::vector<double> kernel(2 * radius + 1);
+	double sum = 0;
+	for (int x = -radius; x <= radius; ++x)
+	{
+		kernel[x + radius] = std::exp(-(x * x) / (2 * sigma * sigma));
+		sum += kernel[x + radius];
+	}
+	for (auto& weight : kernel)
+	{
+		weight /= sum;
+	}
+
+	const auto* data = img.GetData();
+	const auto size = static_cast<size_t>(width) * height * 3;
+	std::vector<double> linear(size);
+	for (size_t i = 0; i < size; ++i)
+	{
+		linear[i] = std::pow(data[i] / 255.0, 2.2);
+	}
+
+	std::vector<double> horizontal(size);
+	pool.ParallelFor(height, [&](const size_t start, const size_t end) {
+		for (auto y = static_cast<int>(start); y < static_cast<int>(end); ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					double value = 0;
+					for (int k = -radius; k <= radius; ++k)
+					{
+						const auto px = std::clamp(x + k, 0, width - 1);
+						value += linear[(static_cast<size_t>(y) * width + px) * 3 + c] * kernel[k + radius];
+					}
+					horizontal[(static_cast<size_t>(y) * width + x) * 3 + c] = value;
+				}
+			}
+		}
+	});
+
+	std::vector<unsigned char> result(size);
+	pool.ParallelFor(height, [&](const size_t start, const size_t end) {
+		for (auto y = static_cast<int>(start); y < static_cast<int>(end); ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					double value = 0;
+					for (int k = -radius; k <= radius; ++k)
+					{
+						const auto py = std::clamp(y + k, 0, height - 1);
+						value += horizontal[(static_cast<size_t>(py) * width + x) * 3 + c] * kernel[k + radius];
+					}
+					result[(static_cast<size_t>(y) * width + x) * 3 + c] = static_cast<unsigned char>(std::clamp(std::pow(value, 1 / 2.2) * 255, 0.0, 255.0));
+				}
+			}
+		}
+	});
+	return result;
+}
+
+struct ImageError
+{
+	int maxError;
+	// бесконечность - изображения совпадают
+	double psnr;
+};
+
+inline ImageError CompareWithReference(wxImage const& img, std::vector<unsigned char> const& reference)
+{
+	const auto* data = img.GetData();
+	int maxError = 0;
+	double squares = 0;
+	for (size_t i = 0; i < reference.size(); ++i)
+	{
+		const auto diff = std::abs(static_cast<int>(data[i]) - static_cast<int>(reference[i]));
+		maxError = std::max(maxError, diff);
+		squares += static_cast<double>(diff) * diff;
+	}
+	const auto mse = squares / static_cast<double>(reference.size());
+	return { maxError, mse == 0 ? std::numeric_limits<double>::infinity() : 10 * std::log10(255.0 * 255.0 / mse) };
+}
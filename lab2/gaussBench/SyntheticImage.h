@@ -0,0 +1,58 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <wx/image.h>
+
+// Воспроизводимое по seed изображение, в котором есть всё, что по-разному нагружает размытие:
+// плавные градиенты, резкие края прямоугольников, шум и тёмные области, где гамма усиливает ошибку
+inline wxImage GenerateSyntheticImage(const int width, const int height, const uint64_t seed)
+{
+	std::mt19937_64 random(seed);
+	wxImage img(width, height, false);
+	auto* data = img.GetData();
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			auto* pixel = data + (static_cast<size_t>(y) * width + x) * 3;
+			pixel[0] = static_cast<unsigned char>(255 * x / std::max(width - 1, 1));
+			pixel[1] = static_cast<unsigned char>(255 * y / std::max(height - 1, 1));
+			pixel[2] = static_cast<unsigned char>(128 + 127 * std::sin(x * 0.05) * std::cos(y * 0.03));
+		}
+	}
+
+	std::uniform_int_distribution<int> byte(0, 255);
+	const auto rectsNum = 8 + width * height / 40000;
+	for (int i = 0; i < rectsNum; ++i)
+	{
+		const auto x0 = std::uniform_int_distribution(0, width - 1)(random);
+		const auto y0 = std::uniform_int_distribution(0, height - 1)(random);
+		const auto x1 = std::min(width, x0 + std::uniform_int_distribution(4, std::max(4, width / 6))(random));
+		const auto y1 = std::min(height, y0 + std::uniform_int_distribution(4, std::max(4, height / 6))(random));
+		// каждый четвёртый прямоугольник - шум, каждый четвёртый - почти чёрный
+		const auto kind = i % 4;
+		const unsigned char color[] = {
+			static_cast<unsigned char>(byte(random)),
+			static_cast<unsigned char>(byte(random)),
+			static_cast<unsigned char>(byte(random)),
+		};
+		for (int y = y0; y < y1; ++y)
+		{
+			for (int x = x0; x < x1; ++x)
+			{
+				auto* pixel = data + (static_cast<size_t>(y) * width + x) * 3;
+				for (int c = 0; c < 3; ++c)
+				{
+					pixel[c] = kind == 0 ? static_cast<unsigned char>(byte(random))
+						: kind == 1      ? static_cast<unsigned char>(color[c] / 16)
+										 : color[c];
+				}
+			}
+		}
+	}
+
+	return img;
+}
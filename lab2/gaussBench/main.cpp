@@ -0,0 +1,191 @@
+#include "../gauss/Gauss.h"
+#include "../parallel/ThreadPool.h"
+#include "../../lib/commandLine/CommandLine.h"
+#include "BenchReport.h"
+#include "ReferenceBlur.h"
+#include "SyntheticImage.h"
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <wx/wx.h>
+
+struct BenchArgs
+{
+	std::vector<std::pair<int, int>> sizes = { { 640, 480 }, { 1920, 1080 }, { 3840, 2160 } };
+	std::vector<int> radii = { 3, 10, 30 };
+	std::vector<int> threads;
+	std::vector<std::string> modes = { "two-pass", "tiled", "box", "fixed16" };
+	unsigned repeats = 3;
+	uint64_t seed = 42;
+	std::optional<std::string> csvPath;
+};
+
+std::vector<std::string> SplitList(std::string const& list)
+{
+	std::vector<std::string> items;
+	std::istringstream input(list);
+	for (std::string item; std::getline(input, item, ',');)
+	{
+		if (!item.empty())
+		{
+			items.push_back(item);
+		}
+	}
+	return items;
+}
+
+std::vector<int> ParseNumbers(std::string const& list)
+{
+	std::vector<int> numbers;
+	for (const auto& item : SplitList(list))
+	{
+		numbers.push_back(std::stoi(item));
+	}
+	return numbers;
+}
+
+// 1, 2, 4, ... до числа ядер включительно
+std::vector<int> GetDefaultThreads()
+{
+	const auto cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	std::vector<int> threads;
+	for (int n = 1; n < cores; n *= 2)
+	{
+		threads.push_back(n);
+	}
+	threads.push_back(cores);
+	return threads;
+}
+
+// gauss-bench [--sizes 640x480,1920x1080] [--radii 3,10,30] [--threads 1,2,4] [--modes tiled,box] [--repeat N] [--seed S] [--csv file]
+BenchArgs ParseCommandLine(const int argc, char** argv)
+{
+	std::vector<std::string> options(argv + 1, argv + argc);
+	BenchArgs args;
+	if (const auto sizes = ExtractOption(options, "--sizes"))
+	{
+		args.sizes.clear();
+		for (const auto& item : SplitList(*sizes))
+		{
+			const auto x = item.find('x');
+			if (x == std::string::npos)
+			{
+				throw std::invalid_argument("Invalid size " + item);
+			}
+			args.sizes.emplace_back(std::stoi(item.substr(0, x)), std::stoi(item.substr(x + 1)));
+		}
+	}
+	if (const auto radii = ExtractOption(options, "--radii"))
+	{
+		args.radii = ParseNumbers(*radii);
+	}
+	if (const auto threads = ExtractOption(options, "--threads"))
+	{
+		args.threads = ParseNumbers(*threads);
+	}
+	if (const auto modes = ExtractOption(options, "--modes"))
+	{
+		args.modes = SplitList(*modes);
+	}
+	if (const auto repeats = ExtractOption(options, "--repeat"))
+	{
+		args.repeats = static_cast<unsigned>(std::stoul(*repeats));
+	}
+	if (const auto seed = ExtractOption(options, "--seed"))
+	{
+		args.seed = std::stoull(*seed);
+	}
+	args.csvPath = ExtractOption(options, "--csv");
+	if (!options.empty())
+	{
+		throw std::invalid_argument("Unknown option " + options.front());
+	}
+
+	if (args.threads.empty())
+	{
+		args.threads = GetDefaultThreads();
+	}
+	for (const auto& mode : args.modes)
+	{
+		ParseBlurMode(mode);
+	}
+	const auto isPositive = [](const int n) { return n > 0; };
+	if (args.repeats == 0 || !std::ranges::all_of(args.threads, isPositive) || !std::ranges::all_of(args.radii, isPositive)
+		|| !std::ranges::all_of(args.sizes, [](auto const& size) { return size.first > 0 && size.second > 0; }))
+	{
+		throw std::invalid_argument("Invalid arguments");
+	}
+	return args;
+}
+
+// Каждая конфигурация повторяется repeats раз; результат первого повтора сверяется с эталоном в double
+std::vector<BenchResult> RunBench(BenchArgs const& args)
+{
+	ThreadPool referencePool(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+	std::vector<BenchResult> results;
+	for (const auto& [width, height] : args.sizes)
+	{
+		const auto img = GenerateSyntheticImage(width, height, args.seed);
+		for (const auto radius : args.radii)
+		{
+			const auto reference = ReferenceBlur(img, radius, referencePool);
+			for (const auto& mode : args.modes)
+			{
+				for (const auto threads : args.threads)
+				{
+					ThreadPool pool(threads);
+					BenchResult result{ .width = width, .height = height, .radius = radius, .mode = mode, .threads = threads };
+					for (unsigned repeat = 0; repeat < args.repeats; ++repeat)
+					{
+						BlurTimings timings;
+						const auto start = std::chrono::steady_clock::now();
+						const auto blurred = BlurParallel(img, radius, pool, ParseBlurMode(mode), &timings);
+						result.seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+						result.blurSeconds.push_back(std::chrono::duration<double>(timings.blur).count());
+						if (repeat == 0)
+						{
+							const auto [maxError, psnr] = CompareWithReference(blurred, reference);
+							result.maxError = maxError;
+							result.psnr = psnr;
+						}
+					}
+					std::cout << width << "x" << height << " r" << radius << " " << mode << " x" << threads << ": "
+							  << result.GetMedian() * 1000 << "ms, max error " << result.maxError << std::endl;
+					results.push_back(std::move(result));
+				}
+			}
+		}
+	}
+
+	ComputeSpeedup(results);
+	return results;
+}
+
+int main(const int argc, char** argv)
+{
+	try
+	{
+		const auto args = ParseCommandLine(argc, argv);
+		wxInitializer wxInit;
+		if (!wxInit)
+		{
+			throw std::runtime_error("Failed to initialize wxWidgets.");
+		}
+
+		const auto results = RunBench(args);
+		PrintResults(std::cout, results);
+		if (args.csvPath)
+		{
+			WriteCsv(*args.csvPath, results);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
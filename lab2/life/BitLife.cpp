@@ -0,0 +1,591 @@
+#include "BitLife.h"
+
+#include "Generations.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LIFE_WITH_X86_SIMD
+#endif
+
+namespace
+{
+using Word = BitLife::Word;
+// changed (если не nullptr) - флаг на каждые CHANGE_GROUP_WORDS слов, ставится, если группа отличается от row
+using NextRowFunction = void (*)(const Word* above, const Word* row, const Word* below, Word* dst, int words, uint8_t* changed);
+
+// группа - одно слово AVX2 и одна плитка отслеживания активных областей
+constexpr int CHANGE_GROUP_WORDS = 4;
+static_assert(BitLife::ACTIVE_TILE_WORDS == CHANGE_GROUP_WORDS);
+
+// Когда активно не меньше 3/4 плиток, отслеживание дороже пересчёта всего поля (на плотном поле 8192x8192 - на 20-25%).
+// Тогда FULL_STEPS_BETWEEN_PROBES поколений считаются целиком, затем два шага отслеживаются: первый пересчитывает всё
+// и находит настоящие изменения, второй по ним решает, затихло ли поле
+constexpr size_t FULL_STEP_ACTIVE_PERCENT = 75;
+constexpr int FULL_STEPS_BETWEEN_PROBES = 16;
+
+// Следующее состояние слова по трём строкам. w и e - строка, сдвинутая так, что в бите x лежат клетки x - 1 и x + 1.
+// Сверху и снизу складываются по три клетки (0..3, два бита), в своей строке - две (0..2).
+// Младшие биты складываются полным сумматором; клетка жива, если сумма старших битов с его переносом ровно 1
+// (соседей 2 или 3) и младший бит суммы равен 1 или клетка уже жива.
+// Встраивается всегда, чтобы для __m256i собираться с набором инструкций вызывающей функции.
+// Векторы передаются по ссылке: передача __m256i по значению без AVX меняет ABI
+template <typename T>
+[[gnu::always_inline]] inline void NextState(T& next, T const& aboveW, T const& above, T const& aboveE,
+	T const& w, T const& center, T const& e, T const& belowW, T const& below, T const& belowE)
+{
+	const T aboveSum = aboveW ^ above ^ aboveE;
+	const T aboveCarry = (aboveW & above) | (aboveE & (aboveW ^ above));
+	const T belowSum = belowW ^ below ^ belowE;
+	const T belowCarry = (belowW & below) | (belowE & (belowW ^ below));
+	const T middleSum = w ^ e;
+	const T middleCarry = w & e;
+
+	const T ones = aboveSum ^ belowSum ^ middleSum;
+	const T onesCarry = (aboveSum & belowSum) | (middleSum & (aboveSum ^ belowSum));
+
+	const T pairs = aboveCarry ^ belowCarry;
+	const T pairsCarry = aboveCarry & belowCarry;
+	const T rest = middleCarry ^ onesCarry;
+	const T restCarry = middleCarry & onesCarry;
+	const T exactlyOne = (pairs ^ rest) & ~(pairsCarry | restCarry);
+
+	next = exactlyOne & (ones | center);
+}
+
+Word West(const Word* row, const int i)
+{
+	return (row[i] << 1) | (row[i - 1] >> 63);
+}
+
+Word East(const Word* row, const int i)
+{
+	return (row[i] >> 1) | (row[i + 1] << 63);
+}
+
+void NextRowTail(const Word* above, const Word* row, const Word* below, Word* dst, int i, const int words, uint8_t* changed)
+{
+	for (; i < words; ++i)
+	{
+		NextState(dst[i], West(above, i), above[i], East(above, i), West(row, i), row[i], East(row, i), West(below, i), below[i], East(below, i));
+		if (changed && dst[i] != row[i])
+		{
+			changed[i / CHANGE_GROUP_WORDS] = 1;
+		}
+	}
+}
+
+void NextRowScalar(const Word* above, const Word* row, const Word* below, Word* dst, const int words, uint8_t* changed)
+{
+	NextRowTail(above, row, below, dst, 0, words, changed);
+}
+
+#ifdef LIFE_WITH_X86_SIMD
+__attribute__((target("avx2"))) __m256i LoadWords(const Word* p)
+{
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+// Соседние слова берутся невыровненными загрузками со сдвигом на одно слово, переносы между словами - сдвигами на 63
+__attribute__((target("avx2"))) __m256i WestWords(const Word* p)
+{
+	return _mm256_or_si256(_mm256_slli_epi64(LoadWords(p), 1), _mm256_srli_epi64(LoadWords(p - 1), 63));
+}
+
+__attribute__((target("avx2"))) __m256i EastWords(const Word* p)
+{
+	return _mm256_or_si256(_mm256_srli_epi64(LoadWords(p), 1), _mm256_slli_epi64(LoadWords(p + 1), 63));
+}
+
+__attribute__((target("avx2"))) void NextRowAvx2(const Word* above, const Word* row, const Word* below, Word* dst, const int words, uint8_t* changed)
+{
+	int i = 0;
+	for (; i + CHANGE_GROUP_WORDS <= words; i += CHANGE_GROUP_WORDS)
+	{
+		__m256i next;
+		const auto center = LoadWords(row + i);
+		NextState(next, WestWords(above + i), LoadWords(above + i), EastWords(above + i),
+			WestWords(row + i), center, EastWords(row + i),
+			WestWords(below + i), LoadWords(below + i), EastWords(below + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), next);
+		if (changed)
+		{
+			const auto difference = _mm256_xor_si256(next, center);
+			changed[i / CHANGE_GROUP_WORDS] |= !_mm256_testz_si256(difference, difference);
+		}
+	}
+	NextRowTail(above, row, below, dst, i, words, changed);
+}
+#endif
+
+struct NextRowImplementation
+{
+	NextRowFunction nextRow;
+	const char* instructionSet;
+};
+
+NextRowImplementation SelectNextRow()
+{
+#ifdef LIFE_WITH_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return { NextRowAvx2, "avx2" };
+	}
+#endif
+	return { NextRowScalar, "scalar" };
+}
+
+NextRowImplementation const& GetNextRow()
+{
+	static const auto implementation = SelectNextRow();
+	return implementation;
+}
+} // namespace
+
+BitLife::BitLife(Field const& field, const int threadsNum)
+	: m_width(field.width)
+	  , m_height(field.height)
+	  , m_words((field.width + WORD_BITS - 1) / WORD_BITS)
+	  , m_stride(m_words + 2)
+	  , m_cells(static_cast<size_t>(m_stride) * m_height)
+	  , m_next(m_cells.size())
+	  , m_pool(threadsNum)
+{
+	for (int y = 0; y < m_height; ++y)
+	{
+		auto* row = GetRow(m_cells, y);
+		for (int x = 0; x < m_width; ++x)
+		{
+			if (field.cells[static_cast<size_t>(y) * m_width + x] == LIVE_CELL)
+			{
+				row[x / WORD_BITS] |= Word{ 1 } << (x % WORD_BITS);
+			}
+		}
+		SetGhostBits(row);
+	}
+}
+
+void BitLife::NextStep()
+{
+	if (m_trackActive)
+	{
+		NextStepActive();
+		return;
+	}
+
+	m_pool.ParallelFor(m_height, [&](const size_t startRow, const size_t endRow) {
+		NextStepForRows(startRow, endRow);
+	});
+
+	std::swap(m_cells, m_next);
+}
+
+void BitLife::Advance(const int generations)
+{
+	if (m_trackActive)
+	{
+		for (int generation = 0; generation < generations; ++generation)
+		{
+			NextStepActive();
+		}
+		return;
+	}
+	if (m_temporalBlock > 1)
+	{
+		for (int done = 0; done < generations; done += m_temporalBlock)
+		{
+			AdvanceTiles(std::min(m_temporalBlock, generations - done));
+		}
+		return;
+	}
+
+	AdvanceGenerations(m_pool, m_height, generations, [&](const size_t startRow, const size_t endRow) {
+		NextStepForRows(startRow, endRow);
+	}, [&] {
+		std::swap(m_cells, m_next);
+	});
+}
+
+void BitLife::SetTemporalBlock(const int generations)
+{
+	if (generations < 0 || generations > MAX_BLOCK_GENERATIONS)
+	{
+		throw std::invalid_argument("Temporal block must be from 0 to " + std::to_string(MAX_BLOCK_GENERATIONS) + " generations");
+	}
+	if (generations > 1 && m_trackActive)
+	{
+		throw std::invalid_argument("Temporal blocking can not be combined with active tracking");
+	}
+	m_temporalBlock = generations;
+}
+
+void BitLife::SetActiveTracking(const bool enabled)
+{
+	if (enabled && m_temporalBlock > 1)
+	{
+		throw std::invalid_argument("Active tracking can not be combined with temporal blocking");
+	}
+	m_trackActive = enabled;
+	if (!enabled)
+	{
+		return;
+	}
+
+	// прошлое поколение считается равным текущему, но изменившимся везде, поэтому первый шаг пересчитывает всё
+	m_next = m_cells;
+	m_tilesX = (m_words + ACTIVE_TILE_WORDS - 1) / ACTIVE_TILE_WORDS;
+	m_tilesY = (m_height + ACTIVE_TILE_ROWS - 1) / ACTIVE_TILE_ROWS;
+	m_changed.assign(static_cast<size_t>(m_tilesX) * m_tilesY, 1);
+	m_nextChanged.assign(m_changed.size(), 0);
+	m_rowNearChanged.assign(m_changed.size(), 0);
+	m_nearChanged.assign(m_changed.size(), 0);
+	m_activeRuns.clear();
+	m_activeTilesNum = 0;
+	m_fullSteps = 0;
+	m_changedMeasured = false;
+}
+
+size_t BitLife::GetActiveTilesNum() const
+{
+	return m_activeTilesNum;
+}
+
+size_t BitLife::GetTilesNum() const
+{
+	return m_changed.size();
+}
+
+void BitLife::NextStepForRows(const size_t startRow, const size_t endRow)
+{
+	const auto nextRow = GetNextRow().nextRow;
+	const auto lastWordMask = GetLastWordMask();
+	for (auto y = static_cast<int>(startRow); y < static_cast<int>(endRow); ++y)
+	{
+		auto* dst = GetRow(m_next, y);
+		nextRow(GetRow(m_cells, (y + m_height - 1) % m_height), GetRow(m_cells, y), GetRow(m_cells, (y + 1) % m_height), dst, m_words, nullptr);
+		// биты за шириной поля посчитаны по призракам и должны быть сброшены до записи новых призраков
+		dst[m_words - 1] &= lastWordMask;
+		dst[m_words] = 0;
+		SetGhostBits(dst);
+	}
+}
+
+void BitLife::AdvanceTiles(const int generations)
+{
+	const auto tilesX = (m_words + TILE_WORDS - 1) / TILE_WORDS;
+	const auto tilesY = (m_height + TILE_ROWS - 1) / TILE_ROWS;
+	m_pool.ParallelFor(static_cast<size_t>(tilesX) * tilesY, 1, [&](const size_t start, const size_t end) {
+		for (auto tile = start; tile < end; ++tile)
+		{
+			AdvanceTile(static_cast<int>(tile % tilesX), static_cast<int>(tile / tilesX), generations);
+		}
+	});
+
+	// призраки строки зависят от её первого и последнего слова, а их могли записать разные плитки
+	m_pool.ParallelFor(m_height, [&](const size_t startRow, const size_t endRow) {
+		for (auto y = static_cast<int>(startRow); y < static_cast<int>(endRow); ++y)
+		{
+			auto* row = GetRow(m_next, y);
+			row[m_words] = 0;
+			SetGhostBits(row);
+		}
+	});
+
+	std::swap(m_cells, m_next);
+}
+
+// Плитка, которая и соседи которой не изменились, не изменится и сейчас. В следующем буфере лежит прошлое поколение,
+// равное текущему в такой плитке, поэтому её можно не трогать. Активные плитки ряда склеиваются в отрезки, чтобы
+// строки считались длинными кусками как без отслеживания, отрезки делятся между потоками
+void BitLife::NextStepActive()
+{
+	if (m_fullSteps > 0)
+	{
+		NextStepFull();
+		return;
+	}
+
+	FindNearChanged();
+	m_activeRuns.clear();
+	m_activeTilesNum = 0;
+	for (int tileY = 0; tileY < m_tilesY; ++tileY)
+	{
+		for (int tileX = 0; tileX < m_tilesX; ++tileX)
+		{
+			if (!m_nearChanged[static_cast<size_t>(tileY) * m_tilesX + tileX])
+			{
+				continue;
+			}
+			++m_activeTilesNum;
+			if (!m_activeRuns.empty() && m_activeRuns.back().tileY == tileY && m_activeRuns.back().endTileX == tileX)
+			{
+				++m_activeRuns.back().endTileX;
+			}
+			else
+			{
+				m_activeRuns.push_back({ tileY, tileX, tileX + 1 });
+			}
+		}
+	}
+	if (m_changedMeasured && m_activeTilesNum * 100 >= m_changed.size() * FULL_STEP_ACTIVE_PERCENT)
+	{
+		m_fullSteps = FULL_STEPS_BETWEEN_PROBES;
+		NextStepFull();
+		return;
+	}
+	m_changedMeasured = true;
+
+	std::ranges::fill(m_nextChanged, 0);
+	m_pool.ParallelFor(m_activeRuns.size(), [&](const size_t start, const size_t end) {
+		for (auto i = start; i < end; ++i)
+		{
+			NextStepForActiveRun(m_activeRuns[i]);
+		}
+	});
+
+	// Призраки строки зависят от её первой и последней плитки. Если пересчитана только одна из них, а строка целиком
+	// не досталась одному отрезку, призраки ставятся отдельно: плитки могли считаться разными потоками
+	m_pool.ParallelFor(m_tilesY, [&](const size_t startTileY, const size_t endTileY) {
+		for (auto tileY = startTileY; tileY < endTileY; ++tileY)
+		{
+			const auto* near = m_nearChanged.data() + tileY * m_tilesX;
+			const auto fullRow = std::all_of(near, near + m_tilesX, [](const uint8_t active) { return active != 0; });
+			if (fullRow || (!near[0] && !near[m_tilesX - 1]))
+			{
+				continue;
+			}
+			const auto startRow = static_cast<int>(tileY) * ACTIVE_TILE_ROWS;
+			for (auto y = startRow; y < std::min(startRow + ACTIVE_TILE_ROWS, m_height); ++y)
+			{
+				SetGhostBits(GetRow(m_next, y));
+			}
+		}
+	});
+
+	std::swap(m_cells, m_next);
+	std::swap(m_changed, m_nextChanged);
+}
+
+// Поколение без отслеживания. Изменившимися считаются все плитки, поэтому следующий отслеживаемый шаг пересчитает всё
+void BitLife::NextStepFull()
+{
+	m_pool.ParallelFor(m_height, [&](const size_t startRow, const size_t endRow) {
+		NextStepForRows(startRow, endRow);
+	});
+	std::swap(m_cells, m_next);
+	std::ranges::fill(m_changed, 1);
+	m_changedMeasured = false;
+	m_activeTilesNum = m_changed.size();
+	--m_fullSteps;
+}
+
+void BitLife::NextStepForActiveRun(ActiveRun const& run)
+{
+	const auto nextRow = GetNextRow().nextRow;
+	const auto startWord = run.startTileX * ACTIVE_TILE_WORDS;
+	const auto endWord = std::min(run.endTileX * ACTIVE_TILE_WORDS, m_words);
+	const auto startRow = run.tileY * ACTIVE_TILE_ROWS;
+	const auto endRow = std::min(startRow + ACTIVE_TILE_ROWS, m_height);
+	auto* changed = m_nextChanged.data() + static_cast<size_t>(run.tileY) * m_tilesX;
+	// отрезок во всю строку владеет и её призраками
+	const auto fullRow = run.startTileX == 0 && run.endTileX == m_tilesX;
+	// в последней плитке биты за шириной поля до маски не совпадают с призраками, её изменение проверяется после маски
+	const auto lastTile = run.endTileX == m_tilesX;
+	const auto lastTileWord = (m_tilesX - 1) * ACTIVE_TILE_WORDS;
+	const auto trackedEndWord = lastTile ? lastTileWord : endWord;
+	const auto lastWordMask = GetLastWordMask();
+
+	for (int y = startRow; y < endRow; ++y)
+	{
+		const auto* above = GetRow(m_cells, (y + m_height - 1) % m_height);
+		const auto* row = GetRow(m_cells, y);
+		const auto* below = GetRow(m_cells, (y + 1) % m_height);
+		auto* dst = GetRow(m_next, y);
+		if (startWord < trackedEndWord)
+		{
+			nextRow(above + startWord, row + startWord, below + startWord, dst + startWord, trackedEndWord - startWord, changed + run.startTileX);
+		}
+		if (lastTile)
+		{
+			nextRow(above + lastTileWord, row + lastTileWord, below + lastTileWord, dst + lastTileWord, m_words - lastTileWord, nullptr);
+			dst[m_words - 1] &= lastWordMask;
+			Word difference = (dst[m_words - 1] ^ row[m_words - 1]) & lastWordMask;
+			for (int i = lastTileWord; i < m_words - 1; ++i)
+			{
+				difference |= dst[i] ^ row[i];
+			}
+			changed[m_tilesX - 1] |= difference != 0;
+		}
+		if (fullRow)
+		{
+			SetGhostBits(dst);
+		}
+	}
+}
+
+// Флаги изменений расширяются на соседей сначала вдоль рядов, потом между рядами.
+// Поле замкнуто в тор, поэтому соседи крайних плиток - плитки с другого края
+void BitLife::FindNearChanged()
+{
+	const auto tilesX = static_cast<size_t>(m_tilesX);
+	const auto tilesY = static_cast<size_t>(m_tilesY);
+	for (size_t y = 0; y < tilesY; ++y)
+	{
+		const auto* changed = m_changed.data() + y * tilesX;
+		auto* near = m_rowNearChanged.data() + y * tilesX;
+		for (size_t x = 0; x < tilesX; ++x)
+		{
+			near[x] = changed[x == 0 ? tilesX - 1 : x - 1] | changed[x] | changed[x + 1 == tilesX ? 0 : x + 1];
+		}
+	}
+
+	for (size_t y = 0; y < tilesY; ++y)
+	{
+		const auto* above = m_rowNearChanged.data() + (y == 0 ? tilesY - 1 : y - 1) * tilesX;
+		const auto* row = m_rowNearChanged.data() + y * tilesX;
+		const auto* below = m_rowNearChanged.data() + (y + 1 == tilesY ? 0 : y + 1) * tilesX;
+		auto* near = m_nearChanged.data() + y * tilesX;
+		for (size_t x = 0; x < tilesX; ++x)
+		{
+			near[x] = above[x] | row[x] | below[x];
+		}
+	}
+}
+
+// Плитка копируется в буфер вместе с полем в generations строк сверху и снизу и одним словом слева и справа
+// (с замыканием в тор), буфер без замыкания продвигается на generations поколений. Неверные клетки у краёв буфера
+// за поколение заходят внутрь на одну клетку, поэтому к концу прохода внутренность плитки ещё верна
+void BitLife::AdvanceTile(const int tileX, const int tileY, const int generations)
+{
+	const auto startWord = tileX * TILE_WORDS;
+	const auto tileWords = std::min(TILE_WORDS, m_words - startWord);
+	const auto startRow = tileY * TILE_ROWS;
+	const auto tileRows = std::min(TILE_ROWS, m_height - startRow);
+	const auto rows = tileRows + 2 * generations;
+	// [0][слово поля][tileWords слов][слово поля][0]: нули нужны соседним словам на краях буфера
+	const auto words = tileWords + 2;
+	const auto stride = words + 2;
+
+	// буферы свои у каждого потока и переживают проходы. Слова строк перед чтением всегда записаны,
+	// поэтому обнуляются только крайние нули: от прошлой плитки с другим шагом там может остаться мусор
+	thread_local std::vector<Word> current;
+	thread_local std::vector<Word> next;
+	const auto bufferSize = static_cast<size_t>(stride) * rows;
+	if (current.size() < bufferSize)
+	{
+		current.resize(bufferSize);
+		next.resize(bufferSize);
+	}
+	const auto bufferRow = [stride](std::vector<Word>& buffer, const int y) {
+		return buffer.data() + static_cast<size_t>(y) * stride + 1;
+	};
+	for (int y = 0; y < rows; ++y)
+	{
+		bufferRow(current, y)[-1] = bufferRow(current, y)[words] = 0;
+		bufferRow(next, y)[-1] = bufferRow(next, y)[words] = 0;
+	}
+
+	// целые слова строки копируются как есть, с замыканием собираются только слова за краями строки
+	const auto copyBegin = startWord > 0 ? 0 : 1;
+	const auto copyEnd = std::clamp(m_width / WORD_BITS - startWord + 1, copyBegin, words);
+	for (int y = 0; y < rows; ++y)
+	{
+		const auto* src = GetRow(m_cells, ((startRow - generations + y) % m_height + m_height) % m_height);
+		auto* dst = bufferRow(current, y);
+		std::copy(src + startWord - 1 + copyBegin, src + startWord - 1 + copyEnd, dst + copyBegin);
+		for (int i = 0; i < copyBegin; ++i)
+		{
+			dst[i] = ExtractCells(src, static_cast<int64_t>(startWord + i - 1) * WORD_BITS);
+		}
+		for (int i = copyEnd; i < words; ++i)
+		{
+			dst[i] = ExtractCells(src, static_cast<int64_t>(startWord + i - 1) * WORD_BITS);
+		}
+	}
+
+	const auto nextRow = GetNextRow().nextRow;
+	for (int generation = 1; generation <= generations; ++generation)
+	{
+		// верные строки буфера сужаются на одну с каждой стороны за поколение
+		for (int y = generation; y < rows - generation; ++y)
+		{
+			nextRow(bufferRow(current, y - 1), bufferRow(current, y), bufferRow(current, y + 1), bufferRow(next, y), words, nullptr);
+		}
+		std::swap(current, next);
+	}
+
+	const auto lastWordMask = GetLastWordMask();
+	for (int y = 0; y < tileRows; ++y)
+	{
+		const auto* src = bufferRow(current, generations + y) + 1;
+		auto* dst = GetRow(m_next, startRow + y) + startWord;
+		std::copy_n(src, tileWords, dst);
+		if (startWord + tileWords == m_words)
+		{
+			dst[tileWords - 1] &= lastWordMask;
+		}
+	}
+}
+
+BitLife::Word BitLife::ExtractCells(const Word* row, int64_t x) const
+{
+	x = (x % m_width + m_width) % m_width;
+	if (x % WORD_BITS == 0 && x + WORD_BITS <= m_width)
+	{
+		return row[x / WORD_BITS];
+	}
+
+	// на краю строки клетки собираются по одной
+	Word result = 0;
+	for (int i = 0; i < WORD_BITS; ++i)
+	{
+		const auto cell = (x + i) % m_width;
+		result |= ((row[cell / WORD_BITS] >> (cell % WORD_BITS)) & 1) << i;
+	}
+	return result;
+}
+
+BitLife::Word BitLife::GetLastWordMask() const
+{
+	return m_width % WORD_BITS == 0 ? ~Word{ 0 } : (Word{ 1 } << (m_width % WORD_BITS)) - 1;
+}
+
+Field BitLife::GetField() const
+{
+	Cells cells(static_cast<size_t>(m_width) * m_height);
+	for (int y = 0; y < m_height; ++y)
+	{
+		const auto* row = GetRow(m_cells, y);
+		for (int x = 0; x < m_width; ++x)
+		{
+			cells[static_cast<size_t>(y) * m_width + x] = (row[x / WORD_BITS] >> (x % WORD_BITS)) & 1 ? LIVE_CELL : DEAD_CELL;
+		}
+	}
+	return { m_width, m_height, std::move(cells) };
+}
+
+BitLife::Word* BitLife::GetRow(std::vector<Word>& cells, const int y) const
+{
+	return cells.data() + static_cast<size_t>(y) * m_stride + 1;
+}
+
+const BitLife::Word* BitLife::GetRow(std::vector<Word> const& cells, const int y) const
+{
+	return cells.data() + static_cast<size_t>(y) * m_stride + 1;
+}
+
+void BitLife::SetGhostBits(Word* row) const
+{
+	const auto last = m_width - 1;
+	row[-1] = ((row[last / WORD_BITS] >> (last % WORD_BITS)) & 1) << 63;
+	auto& ghost = row[m_width / WORD_BITS];
+	ghost = (ghost & ~(Word{ 1 } << (m_width % WORD_BITS))) | (row[0] & 1) << (m_width % WORD_BITS);
+}
+
+const char* GetBitLifeInstructionSet()
+{
+	return GetNextRow().instructionSet;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "../parallel/ThreadPool.h"
+#include "Life.h"
+#include <cstdint>
+#include <vector>
+
+// Движок Life с одним битом на клетку: строка хранится 64-битными словами, соседи считаются
+// побитовыми сумматорами сразу для 64 клеток слова (с AVX2 - для 256). Правила и замыкание в тор как у Life.
+// Строка: [слово-призрак слева][ceil(width / 64) слов клеток][слово-призрак справа]. Перед строкой
+// бит 63 левого призрака равен клетке width - 1, а бит width - клетке 0, поэтому сдвиги соседей не ветвятся на краях
+class BitLife
+{
+public:
+	using Word = uint64_t;
+	static constexpr int WORD_BITS = 64;
+	// Плитка временного блокирования: TILE_ROWS строк по TILE_WORDS слов. Вместе с полями и двумя
+	// буферами при 16 поколениях за проход это около 160 КБ - помещается в L2
+	static constexpr int TILE_ROWS = 128;
+	static constexpr int TILE_WORDS = 64;
+	// поле слева и справа - одно слово, поэтому больше 64 поколений за проход не посчитать
+	static constexpr int MAX_BLOCK_GENERATIONS = WORD_BITS;
+	// плитка отслеживания активных областей: 32 строки по 256 клеток, по ширине - одно слово AVX2
+	static constexpr int ACTIVE_TILE_ROWS = 32;
+	static constexpr int ACTIVE_TILE_WORDS = 4;
+
+	BitLife(Field const& field, int threadsNum);
+	void NextStep();
+	// generations поколений подряд постоянной командой потоков с барьером между поколениями,
+	// а при SetTemporalBlock(k > 1) - проходами по плиткам, k поколений за проход
+	void Advance(int generations);
+	// Временное блокирование: плитка с полем в generations клеток считается в своём буфере на generations поколений вперёд,
+	// в поле записывается только её внутренность. Поле проходит через память раз в generations поколений вместо каждого.
+	// Ускорением это не является: шаг упирается в вычисления, а не в память, и на поле 8192x8192 проходы по плиткам
+	// медленнее NextStep на 25-40% из-за копирования в буфер и пересчёта полей. Оставлено для замеров. 0 или 1 - без блокирования
+	void SetTemporalBlock(int generations);
+	// Отслеживание активных областей: пересчитываются только плитки, которые сами или соседи изменились на прошлом
+	// поколении, остальные уже совпадают в обоих буферах. Если активны почти все плитки, поколения считаются целиком
+	// с редкими отслеживаемыми шагами. Не сочетается с временным блокированием
+	void SetActiveTracking(bool enabled);
+	[[nodiscard]] Field GetField() const;
+	// плиток, пересчитанных на последнем поколении, и всего плиток при отслеживании активных областей
+	[[nodiscard]] size_t GetActiveTilesNum() const;
+	[[nodiscard]] size_t GetTilesNum() const;
+
+private:
+	void NextStepForRows(size_t startRow, size_t endRow);
+	void AdvanceTiles(int generations);
+	void AdvanceTile(int tileX, int tileY, int generations);
+	// 64 клетки строки, начиная с x, с замыканием в тор
+	[[nodiscard]] Word ExtractCells(const Word* row, int64_t x) const;
+	[[nodiscard]] Word GetLastWordMask() const;
+
+	// подряд идущие активные плитки одного ряда [startTileX, endTileX)
+	struct ActiveRun
+	{
+		int tileY;
+		int startTileX;
+		int endTileX;
+	};
+
+	void NextStepActive();
+	void NextStepFull();
+	void NextStepForActiveRun(ActiveRun const& run);
+	// m_nearChanged: изменилась ли плитка или её сосед
+	void FindNearChanged();
+	[[nodiscard]] Word* GetRow(std::vector<Word>& cells, int y) const;
+	[[nodiscard]] const Word* GetRow(std::vector<Word> const& cells, int y) const;
+	void SetGhostBits(Word* row) const;
+
+private:
+	int m_width;
+	int m_height;
+	// слов клеток в строке и шаг строки с призраками
+	int m_words;
+	int m_stride;
+	std::vector<Word> m_cells;
+	std::vector<Word> m_next;
+	int m_temporalBlock = 0;
+	bool m_trackActive = false;
+	int m_tilesX = 0;
+	int m_tilesY = 0;
+	// изменилась ли плитка на прошлом поколении и на считаемом; байт на плитку, чтобы потоки не писали в одно слово
+	std::vector<uint8_t> m_changed;
+	std::vector<uint8_t> m_nextChanged;
+	std::vector<uint8_t> m_rowNearChanged;
+	std::vector<uint8_t> m_nearChanged;
+	std::vector<ActiveRun> m_activeRuns;
+	size_t m_activeTilesNum = 0;
+	// сколько ещё поколений считать целиком, не отслеживая изменения
+	int m_fullSteps = 0;
+	// false, если m_changed не посчитан, а заполнен единицами
+	bool m_changedMeasured = false;
+	ThreadPool m_pool;
+};
+
+// Набор инструкций, выбранный для шага BitLife при запуске
+const char* GetBitLifeInstructionSet();
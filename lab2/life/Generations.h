@@ -0,0 +1,42 @@
+#pragma once
+#include "../parallel/ThreadPool.h"
+#include <atomic>
+#include <barrier>
+
+// Продвигает поле на generations поколений постоянной командой потоков пула: каждый участник считает
+// свою полосу строк stepRows(startRow, endRow) в следующий буфер, после поколения все ждут на барьере,
+// завершение которого меняет буферы местами (swapBuffers). Память под поколения не выделяется.
+// Исключение из stepRows выходит из AdvanceGenerations: бросивший участник покидает барьер, остальные - после текущего поколения
+template <typename StepRows, typename SwapBuffers>
+void AdvanceGenerations(ThreadPool& pool, const int height, const int generations, StepRows const& stepRows, SwapBuffers const& swapBuffers)
+{
+	const auto teamSize = pool.GetThreadsNum();
+	std::barrier sync(teamSize, [&]() noexcept {
+		swapBuffers();
+	});
+	std::atomic<bool> failed = false;
+
+	pool.RunTeam([&](const int index) {
+		const auto startRow = static_cast<size_t>(height) * index / teamSize;
+		const auto endRow = static_cast<size_t>(height) * (index + 1) / teamSize;
+		for (int generation = 0; generation < generations; ++generation)
+		{
+			try
+			{
+				stepRows(startRow, endRow);
+			}
+			catch (...)
+			{
+				failed = true;
+				sync.arrive_and_drop();
+				throw;
+			}
+			sync.arrive_and_wait();
+			if (failed)
+			{
+				sync.arrive_and_drop();
+				return;
+			}
+		}
+	});
+}
@@ -0,0 +1,432 @@
+#include "HashLife.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+HashLife::HashLife(Field const& field, int /*threadsNum*/)
+	: m_width(field.width)
+	  , m_height(field.height)
+{
+	m_nodes.push_back({ .population = 0 });
+	m_nodes.push_back({ .population = 1 });
+	m_empty.push_back(DEAD);
+
+	// наименьший корень, накрывающий окно
+	while ((int64_t{ 1 } << m_rootLevel) < std::max(m_width, m_height))
+	{
+		++m_rootLevel;
+	}
+	m_root = Build(m_rootLevel, 0, 0, field);
+}
+
+void HashLife::NextStep()
+{
+	Step(0);
+}
+
+void HashLife::Advance(const int generations)
+{
+	for (int step = 0; (generations >> step) != 0; ++step)
+	{
+		if ((generations >> step) & 1)
+		{
+			Step(step);
+		}
+	}
+}
+
+Field HashLife::GetField() const
+{
+	Cells cells(static_cast<size_t>(m_width) * m_height, DEAD_CELL);
+	FillCells(m_root, 0, 0, cells);
+	return { m_width, m_height, std::move(cells) };
+}
+
+void HashLife::SetMaxNodes(const size_t maxNodes)
+{
+	m_maxNodes = maxNodes;
+}
+
+size_t HashLife::GetNodesNum() const
+{
+	return m_nodes.size();
+}
+
+uint64_t HashLife::GetPopulation() const
+{
+	return CountPopulation(m_root, 0, 0);
+}
+
+size_t HashLife::ChildrenHash::operator()(Children const& children) const
+{
+	auto hash = (static_cast<uint64_t>(children.nw) << 32 | children.ne) * 0x9E3779B97F4A7C15ull;
+	hash ^= (static_cast<uint64_t>(children.sw) << 32 | children.se) * 0xC2B2AE3D27D4EB4Full;
+	return static_cast<size_t>(hash ^ (hash >> 29));
+}
+
+HashLife::NodeId HashLife::Join(const NodeId nw, const NodeId ne, const NodeId sw, const NodeId se)
+{
+	const Children children{ nw, ne, sw, se };
+	if (const auto it = m_table.find(children); it != m_table.end())
+	{
+		return it->second;
+	}
+
+	if (m_nodes.size() >= NO_RESULT)
+	{
+		throw std::runtime_error("HashLife node table is full");
+	}
+	const auto id = static_cast<NodeId>(m_nodes.size());
+	m_nodes.push_back({
+		.nw = nw,
+		.ne = ne,
+		.sw = sw,
+		.se = se,
+		.population = m_nodes[nw].population + m_nodes[ne].population + m_nodes[sw].population + m_nodes[se].population,
+		.level = static_cast<int8_t>(m_nodes[nw].level + 1),
+	});
+	m_table.emplace(children, id);
+	return id;
+}
+
+HashLife::NodeId HashLife::GetEmpty(const int level)
+{
+	while (static_cast<int>(m_empty.size()) <= level)
+	{
+		const auto child = m_empty.back();
+		m_empty.push_back(Join(child, child, child, child));
+	}
+	return m_empty[level];
+}
+
+// узел уровня level с левым верхним углом (x, y)
+HashLife::NodeId HashLife::Build(const int level, const int64_t x, const int64_t y, Field const& field)
+{
+	const auto size = int64_t{ 1 } << level;
+	if (x >= m_width || y >= m_height || x + size <= 0 || y + size <= 0)
+	{
+		return GetEmpty(level);
+	}
+	if (level == 0)
+	{
+		return field.cells[static_cast<size_t>(y) * m_width + x] == LIVE_CELL ? ALIVE : DEAD;
+	}
+
+	const auto half = size / 2;
+	const auto nw = Build(level - 1, x, y, field);
+	const auto ne = Build(level - 1, x + half, y, field);
+	const auto sw = Build(level - 1, x, y + half, field);
+	const auto se = Build(level - 1, x + half, y + half, field);
+	return Join(nw, ne, sw, se);
+}
+
+void HashLife::FillCells(const NodeId id, const int64_t x, const int64_t y, Cells& cells) const
+{
+	auto const& node = m_nodes[id];
+	const auto size = int64_t{ 1 } << node.level;
+	if (node.population == 0 || x >= m_width || y >= m_height || x + size <= 0 || y + size <= 0)
+	{
+		return;
+	}
+	if (node.level == 0)
+	{
+		cells[static_cast<size_t>(y) * m_width + x] = LIVE_CELL;
+		return;
+	}
+
+	const auto half = size / 2;
+	FillCells(node.nw, x, y, cells);
+	FillCells(node.ne, x + half, y, cells);
+	FillCells(node.sw, x, y + half, cells);
+	FillCells(node.se, x + half, y + half, cells);
+}
+
+HashLife::NodeId HashLife::Center(const NodeId id)
+{
+	const auto node = m_nodes[id];
+	return Join(m_nodes[node.nw].se, m_nodes[node.ne].sw, m_nodes[node.sw].ne, m_nodes[node.se].nw);
+}
+
+HashLife::NodeId HashLife::CenterHorizontal(const NodeId west, const NodeId east)
+{
+	const auto w = m_nodes[west];
+	const auto e = m_nodes[east];
+	return Join(w.ne, e.nw, w.se, e.sw);
+}
+
+HashLife::NodeId HashLife::CenterVertical(const NodeId north, const NodeId south)
+{
+	const auto n = m_nodes[north];
+	const auto s = m_nodes[south];
+	return Join(n.sw, n.se, s.nw, s.ne);
+}
+
+// Девять перекрывающихся подузлов уровня k - 1 продвигаются на 2^step поколений. Если step = k - 2, их центры
+// собираются в четыре узла и продвигаются ещё раз (итого 2^(k - 2)), иначе от четырёх узлов берётся центр
+HashLife::NodeId HashLife::Successor(const NodeId id, const int step)
+{
+	const auto node = m_nodes[id];
+	if (node.population == 0)
+	{
+		return GetEmpty(node.level - 1);
+	}
+	if (node.resultStep == step)
+	{
+		return node.result;
+	}
+	if (node.level == 2)
+	{
+		return SuccessorOfLevel2(id);
+	}
+
+	const auto n00 = node.nw;
+	const auto n01 = CenterHorizontal(node.nw, node.ne);
+	const auto n02 = node.ne;
+	const auto n10 = CenterVertical(node.nw, node.sw);
+	const auto n11 = Center(id);
+	const auto n12 = CenterVertical(node.ne, node.se);
+	const auto n20 = node.sw;
+	const auto n21 = CenterHorizontal(node.sw, node.se);
+	const auto n22 = node.se;
+
+	const auto fullSpeed = step == node.level - 2;
+	const auto innerStep = fullSpeed ? step - 1 : step;
+	const auto r00 = Successor(n00, innerStep);
+	const auto r01 = Successor(n01, innerStep);
+	const auto r02 = Successor(n02, innerStep);
+	const auto r10 = Successor(n10, innerStep);
+	const auto r11 = Successor(n11, innerStep);
+	const auto r12 = Successor(n12, innerStep);
+	const auto r20 = Successor(n20, innerStep);
+	const auto r21 = Successor(n21, innerStep);
+	const auto r22 = Successor(n22, innerStep);
+
+	const auto nw = Join(r00, r01, r10, r11);
+	const auto ne = Join(r01, r02, r11, r12);
+	const auto sw = Join(r10, r11, r20, r21);
+	const auto se = Join(r11, r12, r21, r22);
+	const auto result = fullSpeed
+		? Join(Successor(nw, innerStep), Successor(ne, innerStep), Successor(sw, innerStep), Successor(se, innerStep))
+		: Join(Center(nw), Center(ne), Center(sw), Center(se));
+
+	m_nodes[id].result = result;
+	m_nodes[id].resultStep = static_cast<int8_t>(step);
+	return result;
+}
+
+// Узел 4 x 4: центральные 2 x 2 клетки через одно поколение
+HashLife::NodeId HashLife::SuccessorOfLevel2(const NodeId id)
+{
+	const auto node = m_nodes[id];
+	uint32_t bits = 0;
+	const NodeId quadrants[] = { node.nw, node.ne, node.sw, node.se };
+	for (int q = 0; q < 4; ++q)
+	{
+		const auto quadrant = m_nodes[quadrants[q]];
+		const NodeId cells[] = { quadrant.nw, quadrant.ne, quadrant.sw, quadrant.se };
+		for (int c = 0; c < 4; ++c)
+		{
+			const auto x = (q % 2) * 2 + c % 2;
+			const auto y = (q / 2) * 2 + c / 2;
+			bits |= static_cast<uint32_t>(cells[c] == ALIVE) << (y * 4 + x);
+		}
+	}
+
+	NodeId next[4];
+	for (int c = 0; c < 4; ++c)
+	{
+		const auto x = 1 + c % 2;
+		const auto y = 1 + c / 2;
+		int neighbours = 0;
+		for (int dy = -1; dy <= 1; ++dy)
+		{
+			for (int dx = -1; dx <= 1; ++dx)
+			{
+				if (dx != 0 || dy != 0)
+				{
+					neighbours += (bits >> ((y + dy) * 4 + x + dx)) & 1;
+				}
+			}
+		}
+		const auto alive = (bits >> (y * 4 + x)) & 1;
+		next[c] = neighbours == 3 || (alive && neighbours == 2) ? ALIVE : DEAD;
+	}
+
+	const auto result = Join(next[0], next[1], next[2], next[3]);
+	m_nodes[id].result = result;
+	m_nodes[id].resultStep = 0;
+	return result;
+}
+
+// Узел с углом в (x, y) на плоскости, замощённой окном. Узел внутри окна берётся из корня: выровненный - спуском,
+// невыровненный пустой - сразу пустым, остальные собираются из четвертей и запоминаются до конца шага
+HashLife::NodeId HashLife::Wrap(const int level, int64_t x, int64_t y)
+{
+	x = (x % m_width + m_width) % m_width;
+	y = (y % m_height + m_height) % m_height;
+	const auto size = int64_t{ 1 } << level;
+	if (x + size <= m_width && y + size <= m_height)
+	{
+		if (x % size == 0 && y % size == 0)
+		{
+			return Descend(level, x, y);
+		}
+		// узел перекрывает до четырёх выровненных узлов корня
+		const auto left = x / size * size;
+		const auto right = x % size == 0 ? left : left + size;
+		const auto top = y / size * size;
+		const auto bottom = y % size == 0 ? top : top + size;
+		const auto empty = GetEmpty(level);
+		if (Descend(level, left, top) == empty && Descend(level, right, top) == empty
+			&& Descend(level, left, bottom) == empty && Descend(level, right, bottom) == empty)
+		{
+			return GetEmpty(level);
+		}
+	}
+
+	if (static_cast<int>(m_wrapped.size()) <= level)
+	{
+		m_wrapped.resize(level + 1);
+	}
+	const auto key = static_cast<uint64_t>(y) << 32 | static_cast<uint64_t>(x);
+	if (const auto it = m_wrapped[level].find(key); it != m_wrapped[level].end())
+	{
+		return it->second;
+	}
+	const auto half = size / 2;
+	const auto id = Join(Wrap(level - 1, x, y), Wrap(level - 1, x + half, y), Wrap(level - 1, x, y + half), Wrap(level - 1, x + half, y + half));
+	m_wrapped[level].emplace(key, id);
+	return id;
+}
+
+HashLife::NodeId HashLife::Descend(const int level, const int64_t x, const int64_t y) const
+{
+	auto id = m_root;
+	for (int current = m_rootLevel; current > level; --current)
+	{
+		const auto& node = m_nodes[id];
+		const auto half = int64_t{ 1 } << (current - 1);
+		const auto east = (x & half) != 0;
+		const auto south = (y & half) != 0;
+		id = south ? (east ? node.se : node.sw) : (east ? node.ne : node.nw);
+	}
+	return id;
+}
+
+// живые клетки узла с углом (x, y), попавшие в окно
+uint64_t HashLife::CountPopulation(const NodeId id, const int64_t x, const int64_t y) const
+{
+	auto const& node = m_nodes[id];
+	const auto size = int64_t{ 1 } << node.level;
+	if (node.population == 0 || x >= m_width || y >= m_height)
+	{
+		return 0;
+	}
+	if (x + size <= m_width && y + size <= m_height)
+	{
+		return node.population;
+	}
+
+	const auto half = size / 2;
+	return CountPopulation(node.nw, x, y) + CountPopulation(node.ne, x + half, y)
+		+ CountPopulation(node.sw, x, y + half) + CountPopulation(node.se, x + half, y + half);
+}
+
+// Узел уровня level с окном в центральной половине и запасом в четверть узла с каждой стороны собирается из копий окна.
+// За 2^step <= 2^(level - 2) поколений до центра доходят только клетки запаса, поэтому центр результата - шаг тора.
+// Результат накрывает [0, 2^(level - 1)), от него остаётся наименьший угловой узел, накрывающий окно
+void HashLife::Step(const int step)
+{
+	const auto level = std::max(m_rootLevel + 1, step + 2);
+	const auto margin = int64_t{ 1 } << (level - 2);
+	const auto source = Wrap(level, -margin, -margin);
+	m_wrapped.clear();
+	auto root = Successor(source, step);
+	for (int current = level - 1; current > m_rootLevel; --current)
+	{
+		root = m_nodes[root].nw;
+	}
+	m_root = root;
+
+	if (m_nodes.size() > m_maxNodes)
+	{
+		CollectGarbage();
+	}
+}
+
+// Оставляет узлы, достижимые из корня, и пустые узлы; запомненные результаты на удалённые узлы забываются
+void HashLife::CollectGarbage()
+{
+	std::vector<bool> marked(m_nodes.size());
+	std::vector<NodeId> stack;
+	const auto mark = [&](const NodeId id) {
+		if (!marked[id])
+		{
+			marked[id] = true;
+			stack.push_back(id);
+		}
+	};
+	mark(DEAD);
+	mark(ALIVE);
+	for (const auto empty : m_empty)
+	{
+		mark(empty);
+	}
+	mark(m_root);
+	while (!stack.empty())
+	{
+		const auto node = m_nodes[stack.back()];
+		stack.pop_back();
+		if (node.level > 0)
+		{
+			mark(node.nw);
+			mark(node.ne);
+			mark(node.sw);
+			mark(node.se);
+		}
+	}
+
+	std::vector<NodeId> remap(m_nodes.size(), NO_RESULT);
+	std::vector<Node> nodes;
+	nodes.reserve(std::count(marked.begin(), marked.end(), true));
+	for (NodeId id = 0; id < m_nodes.size(); ++id)
+	{
+		if (marked[id])
+		{
+			remap[id] = static_cast<NodeId>(nodes.size());
+			nodes.push_back(m_nodes[id]);
+		}
+	}
+
+	m_table.clear();
+	for (NodeId id = 0; id < nodes.size(); ++id)
+	{
+		auto& node = nodes[id];
+		if (node.level == 0)
+		{
+			continue;
+		}
+		node.nw = remap[node.nw];
+		node.ne = remap[node.ne];
+		node.sw = remap[node.sw];
+		node.se = remap[node.se];
+		if (node.result != NO_RESULT && remap[node.result] != NO_RESULT)
+		{
+			node.result = remap[node.result];
+		}
+		else
+		{
+			node.result = NO_RESULT;
+			node.resultStep = -1;
+		}
+		m_table.emplace(Children{ node.nw, node.ne, node.sw, node.se }, id);
+	}
+
+	for (auto& empty : m_empty)
+	{
+		empty = remap[empty];
+	}
+	m_root = remap[m_root];
+	m_nodes = std::move(nodes);
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "Life.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Движок HashLife: поле - канонизированное квадродерево, одинаковые поддеревья хранятся один раз (хеш-таблица
+// узлов), а результат узла на 2^j поколений вперёд запоминается в нём. Периодические и разреженные узоры
+// поэтому продвигаются на 2^j поколений за время, зависящее от числа различных узлов, а не от площади.
+//
+// Поле замкнуто в тор, как в Life и BitLife: перед каждым шагом на 2^j поколений окно [0, width) x [0, height)
+// замощается копиями себя с запасом 2^j клеток по краям, и от результата берётся окно. Узлы внутри окна берутся
+// из корня как есть, заново собираются только узлы на стыках копий, так что шаг стоит ещё и порядка площади окна,
+// если его стороны не степени двойки.
+// Считает в одном потоке
+class HashLife
+{
+public:
+	using NodeId = uint32_t;
+	// по умолчанию сборка мусора запускается, когда узлов больше 4 миллионов (около 300 МБ с таблицей)
+	static constexpr size_t DEFAULT_MAX_NODES = size_t{ 1 } << 22;
+
+	HashLife(Field const& field, int threadsNum);
+	void NextStep();
+	void Advance(int generations);
+	[[nodiscard]] Field GetField() const;
+
+	// Порог числа узлов, после которого между шагами удаляются узлы, недостижимые из корня.
+	// Порог мягкий: внутри одного шага на 2^j поколений таблица может вырасти больше
+	void SetMaxNodes(size_t maxNodes);
+	[[nodiscard]] size_t GetNodesNum() const;
+	[[nodiscard]] uint64_t GetPopulation() const;
+
+private:
+	static constexpr NodeId DEAD = 0;
+	static constexpr NodeId ALIVE = 1;
+	static constexpr NodeId NO_RESULT = UINT32_MAX;
+
+	// уровень k - квадрат 2^k x 2^k, листья (уровень 0) - DEAD и ALIVE
+	struct Node
+	{
+		NodeId nw = DEAD;
+		NodeId ne = DEAD;
+		NodeId sw = DEAD;
+		NodeId se = DEAD;
+		uint64_t population = 0;
+		// центр узла через 2^resultStep поколений, уровень на 1 меньше
+		NodeId result = NO_RESULT;
+		int8_t resultStep = -1;
+		int8_t level = 0;
+	};
+
+	struct Children
+	{
+		NodeId nw;
+		NodeId ne;
+		NodeId sw;
+		NodeId se;
+		bool operator==(Children const&) const = default;
+	};
+
+	struct ChildrenHash
+	{
+		size_t operator()(Children const& children) const;
+	};
+
+	[[nodiscard]] NodeId Join(NodeId nw, NodeId ne, NodeId sw, NodeId se);
+	[[nodiscard]] NodeId GetEmpty(int level);
+	[[nodiscard]] NodeId Build(int level, int64_t x, int64_t y, Field const& field);
+	void FillCells(NodeId id, int64_t x, int64_t y, Cells& cells) const;
+
+	[[nodiscard]] NodeId Center(NodeId id);
+	[[nodiscard]] NodeId CenterHorizontal(NodeId west, NodeId east);
+	[[nodiscard]] NodeId CenterVertical(NodeId north, NodeId south);
+	// центр узла уровня k через 2^step поколений, step <= k - 2
+	[[nodiscard]] NodeId Successor(NodeId id, int step);
+	[[nodiscard]] NodeId SuccessorOfLevel2(NodeId id);
+	// узел уровня level с левым верхним углом (x, y) на плоскости, замощённой окном из корня
+	[[nodiscard]] NodeId Wrap(int level, int64_t x, int64_t y);
+	// выровненный по своему размеру узел корня
+	[[nodiscard]] NodeId Descend(int level, int64_t x, int64_t y) const;
+	[[nodiscard]] uint64_t CountPopulation(NodeId id, int64_t x, int64_t y) const;
+	void Step(int step);
+	void CollectGarbage();
+
+private:
+	int m_width;
+	int m_height;
+	std::vector<Node> m_nodes;
+	std::unordered_map<Children, NodeId, ChildrenHash> m_table;
+	// пустой узел каждого уровня
+	std::vector<NodeId> m_empty;
+	// корень покрывает [0, 2^m_rootLevel) по обеим осям, клетки вне окна в нём не важны
+	NodeId m_root;
+	int m_rootLevel = 0;
+	// собранные на этом шаге узлы замощения: по уровню, ключ - (y << 32) | x угла в окне
+	std::vector<std::unordered_map<uint64_t, NodeId>> m_wrapped;
+	size_t m_maxNodes = DEFAULT_MAX_NODES;
+};
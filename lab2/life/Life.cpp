@@ -1,37 +1,34 @@
 #include "Life.h"
 
-#include <thread>
+#include "Generations.h"
 #include <utility>
 
 Life::Life(Field field, const int threadsNum)
 	: m_cells(std::move(field.cells))
+	  , m_next(m_cells.size())
 	  , m_width(field.width)
 	  , m_height(field.height)
-	  , m_threadsNum(threadsNum)
+	  , m_pool(threadsNum)
 {
 }
 
 void Life::NextStep()
 {
-	Cells result;
-	const auto size = m_cells.size();
-	result.resize(size);
+	// куски - целые строки, чтобы соседние потоки не писали в одни и те же строки кэша
+	m_pool.ParallelFor(m_height, [&](const size_t startRow, const size_t endRow) {
+		NextStepForBlock(startRow * m_width, endRow * m_width, m_next);
+	});
 
-	const auto blockSize = size / m_threadsNum;
-	{
-		std::vector<std::jthread> threads(m_threadsNum - 1);
-		size_t blockStart = 0;
-		for (size_t i = 0; i < m_threadsNum - 1; ++i)
-		{
-			auto blockEnd = blockStart;
-			blockEnd += blockSize;
-			threads[i] = std::jthread{ &Life::NextStepForBlock, this, blockStart, blockEnd, std::ref(result) };
-			blockStart = blockEnd;
-		}
-		NextStepForBlock(blockStart, size, result);
-	}
+	std::swap(m_cells, m_next);
+}
 
-	m_cells = std::move(result);
+void Life::Advance(const int generations)
+{
+	AdvanceGenerations(m_pool, m_height, generations, [&](const size_t startRow, const size_t endRow) {
+		NextStepForBlock(startRow * m_width, endRow * m_width, m_next);
+	}, [&] {
+		std::swap(m_cells, m_next);
+	});
 }
 
 void Life::NextStepForBlock(const size_t begin, const size_t end, Cells& result) const
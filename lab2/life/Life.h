@@ -1,4 +1,5 @@
 #pragma once
+#include "../parallel/ThreadPool.h"
 #include <vector>
 
 constexpr char LIVE_CELL = '#';
@@ -24,6 +25,8 @@ class Life
 public:
 	Life(Field field, int threadsNum);
 	void NextStep();
+	// generations поколений подряд постоянной командой потоков с барьером между поколениями
+	void Advance(int generations);
 	[[nodiscard]] Field GetField() const;
 
 private:
@@ -36,7 +39,9 @@ private:
 
 private:
 	Cells m_cells;
+	// следующее поколение, буферы меняются местами после шага
+	Cells m_next;
 	int m_width;
 	int m_height;
-	int m_threadsNum;
+	ThreadPool m_pool;
 };
\ No newline at end of file
@@ -1,16 +1,53 @@
 #pragma once
 #include <fstream>
+#include "BitLife.h"
+#include "HashLife.h"
 #include "Life.h"
-#include "../../lab1/Timer.h"
 
+#include <chrono>
+#include <iostream>
 #include <optional>
+#include <stdexcept>
 #include <string>
 
+// cells - клетка в char, bits - бит на клетку (BitLife), hashlife - квадродерево с запоминанием шагов (HashLife)
+enum class LifeEngine
+{
+	Cells,
+	Bits,
+	HashLife,
+};
+
+inline LifeEngine ParseLifeEngine(std::string const& name)
+{
+	if (name == "cells")
+	{
+		return LifeEngine::Cells;
+	}
+	if (name == "bits")
+	{
+		return LifeEngine::Bits;
+	}
+	if (name == "hashlife")
+	{
+		return LifeEngine::HashLife;
+	}
+	throw std::invalid_argument("Unknown life engine: " + name);
+}
+
 struct StepMode
 {
 	std::string inputFileName;
 	int threadsNum;
 	std::optional<std::string> outputFileName;
+	LifeEngine engine = LifeEngine::Bits;
+	int generations = 1;
+	// поколений за проход временного блокирования, только для bits и только для замеров (медленнее обычного шага); 0 - без блокирования
+	int temporalBlock = 0;
+	// порог узлов для сборки мусора, только для hashlife
+	std::optional<size_t> maxNodes;
+	// пересчитывать только плитки с изменениями рядом, только для bits
+	bool trackActive = false;
 };
 
 inline Field ReadField(const std::string& inputFileName)
@@ -39,7 +76,7 @@ inline void WriteField(const std::string& outputFileName, const Field& field)
 	std::ofstream output(outputFileName);
 	const auto [width, height, cells] = field;
 	output << width << ' ' << height << std::endl;
-	for (int i = 0; i < cells.size(); ++i)
+	for (int i = 0; i < static_cast<int>(cells.size()); ++i)
 	{
 		output << cells[i];
 		if ((i + 1) % width == 0 && i != 0)
@@ -50,11 +87,65 @@ inline void WriteField(const std::string& outputFileName, const Field& field)
 }
 
 
+// Engine - Life, BitLife или HashLife: Advance и GetField
+template <typename Engine>
+void RunEngine(StepMode const& mode, Field const& field, Engine& life)
+{
+	const auto start = std::chrono::steady_clock::now();
+	life.Advance(mode.generations);
+	const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Life: " << mode.generations << " generations took " << seconds * 1000 << "ms, "
+			  << mode.generations / seconds << " generations/s, "
+			  << static_cast<double>(field.width) * field.height * mode.generations / seconds << " cells/s" << std::endl;
+	WriteField(mode.outputFileName.value_or(mode.inputFileName), life.GetField());
+}
+
 inline void Run(StepMode const& mode)
 {
-	const auto [inputFileName, threadsNum, outputFileName] = mode;
-	const auto field = ReadField(inputFileName);
-	Life life(field, threadsNum);
-	MeasureTime(std::cout, "Life", &Life::NextStep, life);
-	WriteField(outputFileName.value_or(inputFileName), life.GetField());
+	if ((mode.temporalBlock != 0 || mode.trackActive) && mode.engine != LifeEngine::Bits)
+	{
+		throw std::invalid_argument("Temporal blocking and active tracking are supported only by the bits engine");
+	}
+	if (mode.maxNodes && mode.engine != LifeEngine::HashLife)
+	{
+		throw std::invalid_argument("--max-nodes is supported only by the hashlife engine");
+	}
+	const auto field = ReadField(mode.inputFileName);
+	switch (mode.engine)
+	{
+	case LifeEngine::Cells:
+	{
+		Life life(field, mode.threadsNum);
+		RunEngine(mode, field, life);
+		break;
+	}
+	case LifeEngine::Bits:
+	{
+		std::cout << "Bit engine instruction set: " << GetBitLifeInstructionSet() << std::endl;
+		BitLife life(field, mode.threadsNum);
+		life.SetTemporalBlock(mode.temporalBlock);
+		life.SetActiveTracking(mode.trackActive);
+		RunEngine(mode, field, life);
+		if (mode.trackActive)
+		{
+			std::cout << "Active tiles on the last generation: " << life.GetActiveTilesNum() << " of " << life.GetTilesNum() << std::endl;
+		}
+		break;
+	}
+	case LifeEngine::HashLife:
+	{
+		if (mode.threadsNum > 1)
+		{
+			std::cerr << "HashLife engine is single-threaded, " << mode.threadsNum << " threads requested, 1 used" << std::endl;
+		}
+		HashLife life(field, mode.threadsNum);
+		if (mode.maxNodes)
+		{
+			life.SetMaxNodes(*mode.maxNodes);
+		}
+		RunEngine(mode, field, life);
+		std::cout << "HashLife: " << life.GetNodesNum() << " nodes, population " << life.GetPopulation() << std::endl;
+		break;
+	}
+	}
 }
\ No newline at end of file
@@ -1,13 +1,48 @@
 #include "GenerateMode.h"
 #include "StepMode.h"
+#include "../../lib/commandLine/CommandLine.h"
 #include <cstdlib>
 #include <iostream>
+#include <optional>
 #include <ostream>
 #include <stdexcept>
+#include <string>
 #include <variant>
+#include <vector>
 
 using ProgramMode = std::variant<GeneratorMode, StepMode>;
 
+// life step <input> <threads> [output] [--engine cells|bits|hashlife] [--generations N] [--temporal-block K] [--max-nodes N]
+// [--active-tiles]
+StepMode ParseStepMode(std::vector<std::string> args)
+{
+	const auto engine = ExtractOption(args, "--engine");
+	const auto generations = ExtractOption(args, "--generations");
+	const auto temporalBlock = ExtractOption(args, "--temporal-block");
+	const auto maxNodes = ExtractOption(args, "--max-nodes");
+	const auto trackActive = ExtractFlag(args, "--active-tiles");
+	if (args.size() != 2 && args.size() != 3)
+	{
+		throw std::runtime_error("Invalid arguments number for step mode");
+	}
+
+	const StepMode mode{
+		.inputFileName = args[0],
+		.threadsNum = std::stoi(args[1]),
+		.outputFileName = args.size() == 3 ? std::optional(args[2]) : std::nullopt,
+		.engine = engine ? ParseLifeEngine(*engine) : LifeEngine::Bits,
+		.generations = generations ? std::stoi(*generations) : 1,
+		.temporalBlock = temporalBlock ? std::stoi(*temporalBlock) : 0,
+		.maxNodes = maxNodes ? std::optional<size_t>(std::stoull(*maxNodes)) : std::nullopt,
+		.trackActive = trackActive,
+	};
+	if (mode.generations < 0)
+	{
+		throw std::runtime_error("Invalid generations number");
+	}
+	return mode;
+}
+
 ProgramMode ParseCommandLine(const int argc, char* argv[])
 {
 	if (argc < 4)
@@ -33,16 +68,7 @@ ProgramMode ParseCommandLine(const int argc, char* argv[])
 
 	if (mode == "step")
 	{
-		if (argc != 4 && argc != 5)
-		{
-			throw std::runtime_error("Invalid arguments number for step mode");
-		}
-
-		return StepMode{
-			.inputFileName = argv[2],
-			.threadsNum = std::stoi(argv[3]),
-			.outputFileName = argc == 5 ? std::optional<std::string>(argv[4]) : std::nullopt,
-		};
+		return ParseStepMode({ argv + 2, argv + argc });
 	}
 
 	if (mode == "visualize")
@@ -0,0 +1,69 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+// Очередь между стадиями конвейера: Push ждёт, пока в очереди есть место, поэтому быстрая стадия
+// не накапливает в памяти больше capacity элементов. После Close() Pop дочитывает остаток и возвращает nullopt
+template <typename T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(const size_t capacity)
+		: m_capacity(capacity == 0 ? 1 : capacity)
+	{
+	}
+
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	// false - очередь закрыта, элемент не добавлен
+	bool Push(T value)
+	{
+		std::unique_lock lock(m_mutex);
+		m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+		if (m_closed)
+		{
+			return false;
+		}
+		m_items.push_back(std::move(value));
+		lock.unlock();
+		m_notEmpty.notify_one();
+		return true;
+	}
+
+	std::optional<T> Pop()
+	{
+		std::unique_lock lock(m_mutex);
+		m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+		if (m_items.empty())
+		{
+			return std::nullopt;
+		}
+		auto value = std::move(m_items.front());
+		m_items.pop_front();
+		lock.unlock();
+		m_notFull.notify_one();
+		return value;
+	}
+
+	void Close()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_closed = true;
+		}
+		m_notEmpty.notify_all();
+		m_notFull.notify_all();
+	}
+
+private:
+	const size_t m_capacity;
+	std::mutex m_mutex;
+	std::condition_variable m_notEmpty;
+	std::condition_variable m_notFull;
+	std::deque<T> m_items;
+	bool m_closed = false;
+};
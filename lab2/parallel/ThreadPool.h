@@ -0,0 +1,262 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Постоянные потоки для параллельных циклов: создаются один раз и ждут следующего ParallelFor,
+// поэтому размытие кадра или шаг Life не платят за создание потоков.
+// Вызывающий поток участвует в работе, поэтому рабочих потоков threadsNum - 1
+class ThreadPool
+{
+public:
+	using RangeFunction = std::function<void(size_t start, size_t end)>;
+	using TeamFunction = std::function<void(int index)>;
+
+	// число кусков на участника при автоматическом выборе размера куска: запас для перераспределения
+	static constexpr size_t CHUNKS_PER_THREAD = 8;
+
+	explicit ThreadPool(const int threadsNum)
+		: m_slices(std::max(threadsNum, 1))
+	{
+		for (int i = 1; i < GetThreadsNum(); ++i)
+		{
+			m_workers.emplace_back([this, i](const std::stop_token& stopToken) {
+				WorkerThread(stopToken, i);
+			});
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	[[nodiscard]] int GetThreadsNum() const
+	{
+		return static_cast<int>(m_slices.size());
+	}
+
+	// Вызывает fn(start, end) для кусков [0, size) не больше grain элементов и возвращается, когда выполнены все.
+	// Каждый участник сначала идёт по своей непрерывной части кусков, затем забирает куски у отставших.
+	// Первое исключение из fn пробрасывается вызывающему. Вызовы из разных потоков выполняются по очереди.
+	// Без рабочих потоков, а также при вложенном вызове из fn или из участника RunTeam этого же пула
+	// fn вызывается один раз для всего диапазона в вызывающем потоке
+	void ParallelFor(const size_t size, const size_t grain, RangeFunction const& fn)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+		if (m_workers.empty() || IsInsideJob())
+		{
+			fn(0, size);
+			return;
+		}
+
+		std::lock_guard jobLock(m_jobMutex);
+		JobScope scope(this);
+		m_teamFn = nullptr;
+		m_fn = &fn;
+		m_size = size;
+		m_grain = std::max<size_t>(grain, 1);
+		m_error = nullptr;
+		const auto chunks = (size + m_grain - 1) / m_grain;
+		for (size_t i = 0; i < m_slices.size(); ++i)
+		{
+			m_slices[i].next = chunks * i / m_slices.size();
+			m_slices[i].end = chunks * (i + 1) / m_slices.size();
+		}
+
+		StartJob();
+		RunChunks(0);
+		WaitJob();
+	}
+
+	// Размер куска выбирается так, чтобы на каждого участника пришлось CHUNKS_PER_THREAD кусков
+	void ParallelFor(const size_t size, RangeFunction const& fn)
+	{
+		ParallelFor(size, size / (CHUNKS_PER_THREAD * m_slices.size()), fn);
+	}
+
+	// Вызывает fn(index) для каждого участника, index от 0 до GetThreadsNum() - 1, все вызовы выполняются одновременно.
+	// Поэтому участники могут синхронизироваться между собой, например std::barrier на GetThreadsNum() участников.
+	// Первое исключение пробрасывается вызывающему. Пул не знает о барьере fn: бросающий участник должен сначала
+	// освободить остальных (std::barrier::arrive_and_drop), как это делает AdvanceGenerations.
+	// Вложенный вызов из задания этого же пула не может собрать команду и бросает std::logic_error
+	void RunTeam(TeamFunction const& fn)
+	{
+		if (IsInsideJob())
+		{
+			throw std::logic_error("RunTeam can not be called from a job of the same thread pool");
+		}
+		if (m_workers.empty())
+		{
+			JobScope scope(this);
+			fn(0);
+			return;
+		}
+
+		std::lock_guard jobLock(m_jobMutex);
+		JobScope scope(this);
+		m_teamFn = &fn;
+		m_fn = nullptr;
+		m_error = nullptr;
+		StartJob();
+		RunTeamMember(0);
+		WaitJob();
+	}
+
+private:
+	// куски участника: next увеличивают и владелец, и забирающие работу, поэтому он атомарный
+	struct alignas(64) Slice
+	{
+		std::atomic<size_t> next = 0;
+		size_t end = 0;
+	};
+
+	// Отмечает поток как выполняющий задание пула, чтобы вложенные вызовы не ждали m_jobMutex, который держит он сам
+	class JobScope
+	{
+	public:
+		explicit JobScope(ThreadPool const* pool)
+			: m_previous(std::exchange(t_currentPool, pool))
+		{
+		}
+
+		JobScope(const JobScope&) = delete;
+		JobScope& operator=(const JobScope&) = delete;
+
+		~JobScope()
+		{
+			t_currentPool = m_previous;
+		}
+
+	private:
+		ThreadPool const* m_previous;
+	};
+
+	[[nodiscard]] bool IsInsideJob() const
+	{
+		return t_currentPool == this;
+	}
+
+	void StartJob()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_pending = m_workers.size();
+			++m_generation;
+		}
+		m_jobStarted.notify_all();
+	}
+
+	void WaitJob()
+	{
+		std::unique_lock lock(m_mutex);
+		m_jobFinished.wait(lock, [this] { return m_pending == 0; });
+		if (m_error)
+		{
+			std::rethrow_exception(m_error);
+		}
+	}
+
+	void WorkerThread(const std::stop_token& stopToken, const int index)
+	{
+		JobScope scope(this);
+		uint64_t seenGeneration = 0;
+		while (true)
+		{
+			{
+				std::unique_lock lock(m_mutex);
+				m_jobStarted.wait(lock, stopToken, [&] { return m_generation != seenGeneration; });
+				if (stopToken.stop_requested())
+				{
+					return;
+				}
+				seenGeneration = m_generation;
+			}
+
+			if (m_teamFn)
+			{
+				RunTeamMember(index);
+			}
+			else
+			{
+				RunChunks(index);
+			}
+
+			std::lock_guard lock(m_mutex);
+			if (--m_pending == 0)
+			{
+				m_jobFinished.notify_one();
+			}
+		}
+	}
+
+	void RunTeamMember(const int index)
+	{
+		try
+		{
+			(*m_teamFn)(index);
+		}
+		catch (...)
+		{
+			SetError();
+		}
+	}
+
+	void SetError()
+	{
+		std::lock_guard lock(m_mutex);
+		if (!m_error)
+		{
+			m_error = std::current_exception();
+		}
+	}
+
+	void RunChunks(const size_t index)
+	{
+		for (size_t i = 0; i < m_slices.size(); ++i)
+		{
+			auto& slice = m_slices[(index + i) % m_slices.size()];
+			for (auto chunk = slice.next++; chunk < slice.end; chunk = slice.next++)
+			{
+				const auto start = chunk * m_grain;
+				try
+				{
+					(*m_fn)(start, std::min(start + m_grain, m_size));
+				}
+				catch (...)
+				{
+					SetError();
+				}
+			}
+		}
+	}
+
+	inline static thread_local ThreadPool const* t_currentPool = nullptr;
+
+	std::vector<Slice> m_slices;
+	std::mutex m_jobMutex;
+	RangeFunction const* m_fn = nullptr;
+	TeamFunction const* m_teamFn = nullptr;
+	size_t m_size = 0;
+	size_t m_grain = 1;
+	std::exception_ptr m_error;
+
+	std::mutex m_mutex;
+	std::condition_variable_any m_jobStarted;
+	std::condition_variable m_jobFinished;
+	uint64_t m_generation = 0;
+	size_t m_pending = 0;
+	// объявлены последними: останавливаются раньше, чем разрушается остальное состояние
+	std::vector<std::jthread> m_workers;
+};
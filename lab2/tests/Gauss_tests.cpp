@@ -0,0 +1,68 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../gauss/BoxBlur.h"
+#include "../gauss/Gauss.h"
+#include "../gaussBench/ReferenceBlur.h"
+#include "../gaussBench/SyntheticImage.h"
+#include <cstring>
+
+namespace
+{
+bool HaveSameData(wxImage const& a, wxImage const& b)
+{
+	const auto size = static_cast<size_t>(a.GetWidth()) * a.GetHeight() * 3;
+	return a.GetWidth() == b.GetWidth() && a.GetHeight() == b.GetHeight() && std::memcmp(a.GetData(), b.GetData(), size) == 0;
+}
+} // namespace
+
+TEST_CASE("exact blur modes match the reference kernel")
+{
+	ThreadPool pool(3);
+	// нечётные размеры - неполные блоки и строки; радиус 150 больше плитки, Tiled размывает как TwoPass
+	const auto image = GenerateSyntheticImage(197, 131, 1);
+	for (const auto radius : { 1, 2, 3, 4, 5, 10, 40, 150 })
+	{
+		const auto reference = ReferenceBlur(image, radius, pool);
+		for (const auto mode : { BlurMode::TwoPass, BlurMode::Tiled, BlurMode::Fixed16 })
+		{
+			INFO("radius " << radius << ", mode " << static_cast<int>(mode));
+			const auto error = CompareWithReference(BlurParallel(image, radius, pool, mode), reference);
+			REQUIRE(error.maxError <= 1);
+		}
+	}
+}
+
+TEST_CASE("box blur is exact at small radii and close at large ones")
+{
+	ThreadPool pool(3);
+	const auto image = GenerateSyntheticImage(320, 200, 2);
+	for (int radius = 1; radius < MIN_BOX_BLUR_RADIUS; ++radius)
+	{
+		INFO("small radius " << radius);
+		const auto error = CompareWithReference(BlurParallel(image, radius, pool, BlurMode::Box), ReferenceBlur(image, radius, pool));
+		REQUIRE(error.maxError <= 1);
+	}
+	// радиусы меньше изображения: при большем радиусе каскад средних сильнее расходится с ядром на краях
+	for (const auto radius : { MIN_BOX_BLUR_RADIUS, 10, 40 })
+	{
+		INFO("large radius " << radius);
+		const auto error = CompareWithReference(BlurParallel(image, radius, pool, BlurMode::Box), ReferenceBlur(image, radius, pool));
+		REQUIRE(error.psnr >= 44);
+		REQUIRE(error.maxError <= 35);
+	}
+}
+
+TEST_CASE("blur result does not depend on the number of threads")
+{
+	const auto image = GenerateSyntheticImage(257, 129, 3);
+	ThreadPool single(1);
+	ThreadPool several(4);
+	for (const auto mode : { BlurMode::TwoPass, BlurMode::Tiled, BlurMode::Box, BlurMode::Fixed16 })
+	{
+		for (const auto radius : { 3, 20, 150 })
+		{
+			INFO("radius " << radius << ", mode " << static_cast<int>(mode));
+			REQUIRE(HaveSameData(BlurParallel(image, radius, single, mode), BlurParallel(image, radius, several, mode)));
+		}
+	}
+}
@@ -0,0 +1,192 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../life/BitLife.h"
+#include "../life/HashLife.h"
+#include "../life/Life.h"
+#include <random>
+#include <string>
+
+namespace
+{
+Field MakeRandomField(const int width, const int height, const double probability, const unsigned seed)
+{
+	std::mt19937 gen(seed);
+	std::bernoulli_distribution alive(probability);
+	Cells cells(static_cast<size_t>(width) * height);
+	for (auto& cell : cells)
+	{
+		cell = alive(gen) ? LIVE_CELL : DEAD_CELL;
+	}
+	return { width, height, std::move(cells) };
+}
+
+// Блоки 2x2 по всему полю и один глайдер: почти все плитки затихают, активна только область глайдера
+Field MakeQuietField(const int width, const int height)
+{
+	Field field{ width, height, Cells(static_cast<size_t>(width) * height, DEAD_CELL) };
+	const auto set = [&](const int x, const int y) {
+		field.cells[static_cast<size_t>(y) * width + x] = LIVE_CELL;
+	};
+	for (int y = 40; y + 2 < height; y += 8)
+	{
+		for (int x = 1; x + 2 < width; x += 8)
+		{
+			set(x, y);
+			set(x + 1, y);
+			set(x, y + 1);
+			set(x + 1, y + 1);
+		}
+	}
+	if (width < 10 || height < 5)
+	{
+		return field;
+	}
+	// глайдер летит к краю и уходит через него на другую сторону тора
+	set(width - 9, 2);
+	set(width - 8, 3);
+	set(width - 10, 4);
+	set(width - 9, 4);
+	set(width - 8, 4);
+	return field;
+}
+
+// Эталон - клеточный движок в одном потоке
+Field AdvanceReference(Field const& field, const int generations)
+{
+	Life life(field, 1);
+	life.Advance(generations);
+	return life.GetField();
+}
+
+bool HaveSameCells(Field const& a, Field const& b)
+{
+	return a.width == b.width && a.height == b.height && a.cells == b.cells;
+}
+
+struct FieldSize
+{
+	int width;
+	int height;
+};
+
+// ширины меньше слова, ровно в слово, с неполным последним словом и в несколько плиток
+constexpr FieldSize SIZES[] = { { 3, 5 }, { 50, 40 }, { 64, 64 }, { 65, 33 }, { 130, 97 }, { 300, 260 } };
+constexpr int GENERATIONS = 70;
+} // namespace
+
+TEST_CASE("bit engine matches the cell engine on a torus")
+{
+	for (const auto [width, height] : SIZES)
+	{
+		const auto field = MakeRandomField(width, height, 0.35, static_cast<unsigned>(width * height));
+		const auto expected = AdvanceReference(field, GENERATIONS);
+		for (const auto threadsNum : { 1, 3 })
+		{
+			INFO(width << "x" << height << ", " << threadsNum << " threads");
+			BitLife advanced(field, threadsNum);
+			advanced.Advance(GENERATIONS);
+			REQUIRE(HaveSameCells(advanced.GetField(), expected));
+
+			BitLife stepped(field, threadsNum);
+			for (int generation = 0; generation < GENERATIONS; ++generation)
+			{
+				stepped.NextStep();
+			}
+			REQUIRE(HaveSameCells(stepped.GetField(), expected));
+
+			Life cells(field, threadsNum);
+			cells.Advance(GENERATIONS);
+			REQUIRE(HaveSameCells(cells.GetField(), expected));
+		}
+	}
+}
+
+TEST_CASE("temporal blocking matches the plain step")
+{
+	for (const auto [width, height] : SIZES)
+	{
+		const auto field = MakeRandomField(width, height, 0.35, static_cast<unsigned>(width + height));
+		const auto expected = AdvanceReference(field, GENERATIONS);
+		// 64 - наибольший блок, 70 не делится на 8 и 64: последний проход короче
+		for (const auto block : { 2, 8, BitLife::MAX_BLOCK_GENERATIONS })
+		{
+			for (const auto threadsNum : { 1, 3 })
+			{
+				INFO(width << "x" << height << ", block " << block << ", " << threadsNum << " threads");
+				BitLife life(field, threadsNum);
+				life.SetTemporalBlock(block);
+				life.Advance(GENERATIONS);
+				REQUIRE(HaveSameCells(life.GetField(), expected));
+			}
+		}
+	}
+
+	BitLife life(MakeRandomField(10, 10, 0.5, 1), 1);
+	REQUIRE_THROWS_AS(life.SetTemporalBlock(BitLife::MAX_BLOCK_GENERATIONS + 1), std::invalid_argument);
+	life.SetActiveTracking(true);
+	REQUIRE_THROWS_AS(life.SetTemporalBlock(4), std::invalid_argument);
+}
+
+TEST_CASE("active tile tracking matches the plain step")
+{
+	// плотное поле переходит на шаги целиком, тихое остаётся с отслеживанием; 150 поколений проходят оба режима
+	constexpr int generations = 150;
+	for (const auto [width, height] : SIZES)
+	{
+		const Field fields[] = { MakeRandomField(width, height, 0.35, static_cast<unsigned>(width * 7 + height)), MakeQuietField(width, height) };
+		for (const auto& field : fields)
+		{
+			for (const auto threadsNum : { 1, 3 })
+			{
+				INFO(width << "x" << height << ", population " << std::ranges::count(field.cells, LIVE_CELL) << ", " << threadsNum << " threads");
+				BitLife life(field, threadsNum);
+				life.SetActiveTracking(true);
+				Life reference(field, 1);
+				for (int generation = 0; generation < generations; generation += 10)
+				{
+					life.Advance(10);
+					reference.Advance(10);
+					REQUIRE(HaveSameCells(life.GetField(), reference.GetField()));
+					REQUIRE(life.GetActiveTilesNum() <= life.GetTilesNum());
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("active tracking recomputes only tiles near changes")
+{
+	BitLife life(MakeQuietField(4096, 2048), 1);
+	life.SetActiveTracking(true);
+	life.Advance(40);
+	// блоки неподвижны, глайдер задевает не больше четырёх плиток, с соседями - не больше 4 x 4
+	REQUIRE(life.GetTilesNum() == 16 * 64);
+	REQUIRE(life.GetActiveTilesNum() <= 16);
+	REQUIRE(life.GetActiveTilesNum() > 0);
+}
+
+TEST_CASE("hashlife matches the cell engine on a torus")
+{
+	for (const auto [width, height] : SIZES)
+	{
+		const Field fields[] = { MakeRandomField(width, height, 0.35, static_cast<unsigned>(width * 3 + height)), MakeQuietField(width, height) };
+		for (const auto& field : fields)
+		{
+			// 130 = 128 + 2: в шаге на 128 поколений запас больше малых полей, окно замощается несколькими копиями
+			for (const auto generations : { 1, 37, 130 })
+			{
+				INFO(width << "x" << height << ", population " << std::ranges::count(field.cells, LIVE_CELL) << ", " << generations << " generations");
+				const auto expected = AdvanceReference(field, generations);
+				HashLife life(field, 1);
+				life.Advance(generations);
+				REQUIRE(HaveSameCells(life.GetField(), expected));
+				REQUIRE(life.GetPopulation() == static_cast<uint64_t>(std::ranges::count(expected.cells, LIVE_CELL)));
+
+				HashLife collected(field, 1);
+				collected.SetMaxNodes(1000);
+				collected.Advance(generations);
+				REQUIRE(HaveSameCells(collected.GetField(), expected));
+			}
+		}
+	}
+}
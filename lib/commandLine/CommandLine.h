@@ -0,0 +1,37 @@
+#pragma once
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Удаляет из args "name value" и возвращает value. Опции могут стоять в любом месте командной строки
+inline std::optional<std::string> ExtractOption(std::vector<std::string>& args, std::string const& name)
+{
+	const auto it = std::ranges::find(args, name);
+	if (it == args.end())
+	{
+		return std::nullopt;
+	}
+	if (std::next(it) == args.end())
+	{
+		throw std::invalid_argument("Missing value for " + name);
+	}
+
+	auto value = *std::next(it);
+	args.erase(it, std::next(it, 2));
+	return value;
+}
+
+// Удаляет из args флаг name и сообщает, был ли он
+inline bool ExtractFlag(std::vector<std::string>& args, std::string const& name)
+{
+	const auto it = std::ranges::find(args, name);
+	if (it == args.end())
+	{
+		return false;
+	}
+	args.erase(it);
+	return true;
+}
@@ -84,6 +84,26 @@ public:
 		throw std::system_error(errno, std::generic_category());
 	}
 
+	void Write(const void* buffer, const size_t length)
+	{
+		EnsureOpen();
+		auto data = static_cast<const char*>(buffer);
+		size_t written = 0;
+		while (written < length)
+		{
+			const auto bytesWritten = write(m_desc, data + written, length - written);
+			if (bytesWritten == -1)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				throw std::system_error(errno, std::generic_category());
+			}
+			written += static_cast<size_t>(bytesWritten);
+		}
+	}
+
 private:
 	void EnsureOpen() const
 	{